@@ -0,0 +1,42 @@
+# Writes a C++ source embedding files as constexpr byte arrays, run as a script:
+#   cmake -DROOT=<dir> -DOUTPUT=<file.cpp> -DFILES=<a|b|c> -P EmbedAssets.cmake
+# FILES are relative to ROOT and separated by '|', they become the asset paths looked up by Assets.
+# A file written as path=file embeds file (built somewhere else, like cooked textures) under path.
+
+string(REPLACE "|" ";" FILES "${FILES}")
+
+# CMake regexes have no {n} repetition
+string(REPEAT "0x..," 32 lineOfBytes)
+
+set(arrays "")
+set(table "")
+set(index 0)
+foreach (file IN LISTS FILES)
+    set(source "${ROOT}/${file}")
+    if (file MATCHES "^([^=]+)=(.+)$")
+        set(file "${CMAKE_MATCH_1}")
+        set(source "${CMAKE_MATCH_2}")
+    endif ()
+    file(READ "${source}" hex HEX)
+    string(LENGTH "${hex}" hexLength)
+    math(EXPR size "${hexLength} / 2")
+
+    # One byte per "0x..," and a line break every 32 bytes
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${hex}")
+    string(REGEX REPLACE "(${lineOfBytes})" "\\1\n    " bytes "${bytes}")
+
+    # The trailing zero keeps empty files valid C++ and text assets null terminated
+    string(APPEND arrays "// ${file}\nalignas(16) constexpr unsigned char asset${index}[] = {\n    ${bytes}0x00\n};\n\n")
+    string(APPEND table "    {\"${file}\", {asset${index}, ${size}}},\n")
+    math(EXPR index "${index} + 1")
+endforeach ()
+
+set(content "// Generated by cmake/EmbedAssets.cmake, do not edit\n\n#include \"Assets.h\"\n\nnamespace {\n\n${arrays}}\n\nconst EmbeddedAsset embeddedAssets[] = {\n${table}};\n\nconst size_t embeddedAssetCount = ${index};\n")
+
+# Only touch the output when it changed, so that an unrelated rebuild doesn't recompile it
+if (EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" previous)
+endif ()
+if (NOT "${previous}" STREQUAL "${content}")
+    file(WRITE "${OUTPUT}" "${content}")
+endif ()
@@ -2,12 +2,60 @@
 
 #ifndef OPENGL_TEST_APPCONTEXT_H
 #define OPENGL_TEST_APPCONTEXT_H
+#include <cstdint>
+#include <vector>
+
+#include "FrameArena.h"
+#include "FrameSnapshot.h"
+#include "JobSystem.h"
+#include "MipGenerator.h"
 #include "RenderEngine.h"
+#include "RenderThread.h"
+#include "TripleBuffer.h"
+
+// Options picked from the command line at startup
+struct LaunchOptions {
+    RenderBackend backend = RenderBackend::Window;
+    // Quit after this many frames, 0 means we run until the user quits
+    uint64_t frameLimit = 0;
+    // Number of frames to time with --bench, 0 when not benchmarking
+    uint64_t benchmarkFrames = 0;
+    // Where --bench writes its JSON report, stdout when null
+    const char *benchmarkJsonPath = nullptr;
+    bool programCache = true;
+    // Rebuild shaders when their sources change, with --watch-shaders
+    bool watchShaders = false;
+    // Number of instanced sprites to animate with --sprites
+    size_t spriteCount = 0;
+    // Render from a dedicated thread, or from SDL_AppIterate with --single-thread
+    bool renderThread = true;
+    // Generate texture mipmaps on the worker threads instead of the driver, with --cpu-mipmaps
+    bool cpuMipmaps = false;
+    MipFilter mipFilter = MipFilter::Box;
+};
 
 struct AppContext {
 public:
+    // Shared by every subsystem, outlives the renderer
+    JobSystem jobs;
     RenderEngine renderer;
     SDL_AppResult controlFlow = SDL_APP_CONTINUE;
+    LaunchOptions options;
+
+    // Main thread state
+    bool wireframe = false;
+    uint64_t simulationFrame = 0;
+    std::vector<SpriteInstance> sprites;
+
+    // Written by the main thread, read by whichever thread renders
+    TripleBuffer<FrameSnapshot> frames;
+    // Backs the transient data of each snapshot, one region per mailbox slot
+    FrameArena frameArena;
+    RenderThread renderThread;
+
+    // Only touched by the thread that renders, until it stopped
+    uint64_t frameCount = 0;
+    Benchmark benchmark;
 };
 
 #endif //OPENGL_TEST_APPCONTEXT_H
@@ -0,0 +1,185 @@
+#include "AssetPack.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "SDL3/SDL_log.h"
+
+#include "Hash.h"
+
+using namespace std;
+
+AssetPack::~AssetPack() {
+    this->close();
+}
+
+bool AssetPack::open(const string &path) {
+    this->close();
+    if (not this->map(path)) {
+        return false;
+    }
+    this->path = path;
+
+    if (not this->validate()) {
+        SDL_LogError(0, "Asset pack error: %s is not a valid asset pack", path.c_str());
+        this->close();
+        return false;
+    }
+
+    const auto &header = *reinterpret_cast<const AssetPackHeader *>(this->data);
+    this->entries = {reinterpret_cast<const AssetPackEntry *>(this->data + sizeof(AssetPackHeader)), header.entryCount};
+    this->paths = reinterpret_cast<const char *>(this->data + header.pathsOffset);
+
+    SDL_Log("Asset pack: mapped %s (%llu assets, %llu KiB)", path.c_str(),
+            (unsigned long long) header.entryCount, (unsigned long long) this->size / 1024);
+    return true;
+}
+
+void AssetPack::close() {
+    if (this->data) {
+        this->unmap();
+    }
+    this->data = nullptr;
+    this->size = 0;
+    this->entries = {};
+    this->paths = nullptr;
+    this->path.clear();
+}
+
+const AssetPackEntry *AssetPack::find(const string_view assetPath) const {
+    const uint64_t hash = hashString(assetPath);
+    auto entry = ranges::lower_bound(this->entries, hash, {}, &AssetPackEntry::pathHash);
+
+    // Different paths can share a hash, so the path itself decides
+    for (; entry != this->entries.end() && entry->pathHash == hash; ++entry) {
+        if (string_view(this->paths + entry->pathOffset, entry->pathLength) == assetPath) {
+            return &*entry;
+        }
+    }
+    return nullptr;
+}
+
+bool AssetPack::validate() const {
+    if (this->size < sizeof(AssetPackHeader)) {
+        return false;
+    }
+    const auto &header = *reinterpret_cast<const AssetPackHeader *>(this->data);
+    if (header.magic != assetPackMagic || header.version != assetPackVersion || header.fileSize != this->size) {
+        return false;
+    }
+
+    // Written so that none of the additions can overflow
+    const uint64_t tableSpace = this->size - sizeof(AssetPackHeader);
+    if (header.entryCount > tableSpace / sizeof(AssetPackEntry)) {
+        return false;
+    }
+    const uint64_t tableEnd = sizeof(AssetPackHeader) + header.entryCount * sizeof(AssetPackEntry);
+    if (header.pathsOffset < tableEnd || header.pathsOffset > this->size) {
+        return false;
+    }
+
+    const auto *entries = reinterpret_cast<const AssetPackEntry *>(this->data + sizeof(AssetPackHeader));
+    const uint64_t pathsSize = this->size - header.pathsOffset;
+    for (uint64_t i = 0; i < header.entryCount; i++) {
+        const auto &entry = entries[i];
+        if (entry.pathOffset > pathsSize || entry.pathLength > pathsSize - entry.pathOffset) {
+            return false;
+        }
+        if (entry.offset > this->size || entry.size > this->size - entry.offset) {
+            return false;
+        }
+        if (i != 0 && entries[i - 1].pathHash > entry.pathHash) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef _WIN32
+
+bool AssetPack::map(const string &path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (not GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (not mapping) {
+        SDL_LogError(0, "Asset pack error: CreateFileMapping failed for %s", path.c_str());
+        CloseHandle(file);
+        return false;
+    }
+
+    const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (not view) {
+        SDL_LogError(0, "Asset pack error: MapViewOfFile failed for %s", path.c_str());
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    this->file = file;
+    this->mapping = mapping;
+    this->data = static_cast<const unsigned char *>(view);
+    this->size = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void AssetPack::unmap() {
+    UnmapViewOfFile(this->data);
+    CloseHandle(this->mapping);
+    CloseHandle(this->file);
+    this->mapping = nullptr;
+    this->file = nullptr;
+}
+
+#else
+
+bool AssetPack::map(const string &path) {
+    const int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor == -1) {
+        return false;
+    }
+
+    struct stat status{};
+    if (fstat(descriptor, &status) == -1 || status.st_size == 0) {
+        ::close(descriptor);
+        return false;
+    }
+
+    const auto fileSize = static_cast<size_t>(status.st_size);
+    void *view = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // The mapping keeps the file alive on its own
+    ::close(descriptor);
+    if (view == MAP_FAILED) {
+        SDL_LogError(0, "Asset pack error: mmap failed for %s", path.c_str());
+        return false;
+    }
+
+    this->data = static_cast<const unsigned char *>(view);
+    this->size = fileSize;
+    return true;
+}
+
+void AssetPack::unmap() {
+    munmap(const_cast<unsigned char *>(this->data), this->size);
+}
+
+#endif
@@ -0,0 +1,99 @@
+#pragma once
+
+#ifndef OPENGL_TEST_ASSETPACK_H
+#define OPENGL_TEST_ASSETPACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+/*
+ * Pack file layout, little endian, written by tools/asset_packer.cpp:
+ *   AssetPackHeader
+ *   AssetPackEntry[entryCount], sorted by pathHash
+ *   Asset paths, back to back without terminators
+ *   Asset contents, each starting on an assetPackAlignment boundary
+ * The table of contents comes first, so that opening a pack only faults in its first pages.
+ */
+
+// Bump whenever the file layout changes
+constexpr uint32_t assetPackMagic = 0x4b504741; // "AGPK"
+constexpr uint32_t assetPackVersion = 1;
+// Keeps every asset cache line aligned, and aligned enough for any SIMD load
+constexpr uint64_t assetPackAlignment = 64;
+
+struct AssetPackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fileSize;
+    uint64_t entryCount;
+    uint64_t pathsOffset;
+};
+
+struct AssetPackEntry {
+    // hashString() of the path, relative to the asset root ("shaders/shader.vsh")
+    uint64_t pathHash;
+    // hashBytes() of the contents
+    uint64_t contentHash;
+    uint64_t offset;
+    uint64_t size;
+    // Relative to pathsOffset
+    uint32_t pathOffset;
+    uint32_t pathLength;
+};
+
+static_assert(sizeof(AssetPackHeader) == 32);
+static_assert(sizeof(AssetPackEntry) == 40);
+
+/**
+ * A read-only memory mapped pack file. Assets are spans straight into the mapping, so reading one
+ * costs no copy, only the page faults of the bytes actually touched.
+ *
+ * Lookups don't modify anything and can run from any thread, but the pack must outlive every span
+ * handed out by find().
+ */
+class AssetPack {
+public:
+    std::string path;
+    const unsigned char *data{};
+    size_t size{};
+
+    AssetPack() = default;
+    AssetPack(const AssetPack &) = delete;
+    AssetPack &operator=(const AssetPack &) = delete;
+    ~AssetPack();
+
+    bool open(const std::string &path);
+
+    void close();
+
+    bool isOpen() const { return this->data != nullptr; }
+
+    // Null when the pack doesn't have the asset
+    const AssetPackEntry *find(std::string_view assetPath) const;
+
+    std::span<const unsigned char> contents(const AssetPackEntry &entry) const {
+        return {this->data + entry.offset, entry.size};
+    }
+
+private:
+    std::span<const AssetPackEntry> entries;
+    const char *paths{};
+
+#ifdef _WIN32
+    void *file{};
+    void *mapping{};
+#endif
+
+    // Checks that the table of contents only points inside the file
+    bool validate() const;
+
+    bool map(const std::string &path);
+
+    void unmap();
+};
+
+
+#endif //OPENGL_TEST_ASSETPACK_H
@@ -0,0 +1,92 @@
+#include "Assets.h"
+
+#include <fstream>
+#include <string>
+
+#include "SDL3/SDL_log.h"
+
+#include "Hash.h"
+
+using namespace std;
+
+static string_view normalize(string_view path) {
+    while (path.starts_with("./")) {
+        path.remove_prefix(2);
+    }
+    return path;
+}
+
+bool Assets::mount(const string &path) {
+    return pack.open(path);
+}
+
+void Assets::unmount() {
+    pack.close();
+}
+
+bool Assets::hasEmbedded() {
+#ifdef OPENGL_TEST_EMBEDDED_ASSETS
+    return embeddedAssetCount != 0;
+#else
+    return false;
+#endif
+}
+
+bool Assets::read(const string_view path, AssetData &data) {
+    if (preferFiles) {
+        return readFile(path, data) || readPacked(path, data) || readEmbedded(path, data);
+    }
+    return readEmbedded(path, data) || readPacked(path, data) || readFile(path, data);
+}
+
+bool Assets::readPacked(const string_view path, AssetData &data) {
+    if (not pack.isOpen()) {
+        return false;
+    }
+    const AssetPackEntry *entry = pack.find(normalize(path));
+    if (not entry) {
+        return false;
+    }
+
+    data.storage.clear();
+    data.bytes = pack.contents(*entry);
+#ifndef NDEBUG
+    // Hashing touches every page of the asset, so release builds trust the packer
+    if (hashBytes(data.bytes.data(), data.bytes.size()) != entry->contentHash) {
+        SDL_LogError(0, "Asset pack error: %.*s is corrupted in %s", static_cast<int>(path.size()), path.data(),
+                     pack.path.c_str());
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool Assets::readEmbedded(const string_view path, AssetData &data) {
+#ifdef OPENGL_TEST_EMBEDDED_ASSETS
+    const string_view key = normalize(path);
+    for (size_t i = 0; i < embeddedAssetCount; i++) {
+        if (embeddedAssets[i].path == key) {
+            data.storage.clear();
+            data.bytes = embeddedAssets[i].data;
+            return true;
+        }
+    }
+#endif
+    return false;
+}
+
+bool Assets::readFile(const string_view path, AssetData &data) {
+    ifstream file(string(path), ios::binary | ios::ate);
+    if (not file) {
+        return false;
+    }
+
+    const streamsize size = file.tellg();
+    file.seekg(0);
+    data.storage.resize(static_cast<size_t>(size));
+    if (not file.read(reinterpret_cast<char *>(data.storage.data()), size)) {
+        return false;
+    }
+    data.bytes = data.storage;
+    return true;
+}
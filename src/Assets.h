@@ -0,0 +1,77 @@
+#pragma once
+
+#ifndef OPENGL_TEST_ASSETS_H
+#define OPENGL_TEST_ASSETS_H
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "AssetPack.h"
+
+// An asset compiled into the executable by cmake/EmbedAssets.cmake
+struct EmbeddedAsset {
+    std::string_view path;
+    std::span<const unsigned char> data;
+};
+
+// Defined by the generated EmbeddedAssets.cpp when OPENGL_TEST_EMBEDDED_ASSETS is set
+extern const EmbeddedAsset embeddedAssets[];
+extern const size_t embeddedAssetCount;
+
+/**
+ * Bytes of an asset. Embedded assets point straight at the executable's data, only assets
+ * read from loose files own their bytes.
+ */
+class AssetData {
+public:
+    std::span<const unsigned char> bytes;
+    std::vector<unsigned char> storage;
+
+    AssetData() = default;
+    AssetData(AssetData &&) = default;
+    AssetData &operator=(AssetData &&) = default;
+    // bytes may point into storage, so a copy would point into the original
+    AssetData(const AssetData &) = delete;
+    AssetData &operator=(const AssetData &) = delete;
+
+    std::string_view text() const {
+        return {reinterpret_cast<const char *>(this->bytes.data()), this->bytes.size()};
+    }
+};
+
+/**
+ * Where shaders and textures are read from. Paths are relative to the working directory
+ * ("./shaders/shader.vsh" and "shaders/shader.vsh" are the same asset).
+ *
+ * Assets are looked up in the executable for builds with embedded assets (the default for release
+ * builds), then in the mounted pack, then in loose files. Neither of the first two copies anything.
+ */
+class Assets {
+public:
+    // Loose files first, so that shader hot reload sees the files being edited
+    inline static bool preferFiles = false;
+    inline static AssetPack pack;
+
+    // Maps the pack at path if there is one, assets keep coming from elsewhere otherwise
+    static bool mount(const std::string &path);
+
+    // Every AssetData read from the pack must be gone by then
+    static void unmount();
+
+    static bool hasEmbedded();
+
+    // Logs nothing, returns false when the asset can't be found or read
+    static bool read(std::string_view path, AssetData &data);
+
+private:
+    static bool readPacked(std::string_view path, AssetData &data);
+
+    static bool readEmbedded(std::string_view path, AssetData &data);
+
+    static bool readFile(std::string_view path, AssetData &data);
+};
+
+
+#endif //OPENGL_TEST_ASSETS_H
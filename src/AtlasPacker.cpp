@@ -0,0 +1,86 @@
+#include "AtlasPacker.h"
+
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+void SkylinePacker::init(const int width, const int height) {
+    this->width = width;
+    this->height = height;
+    this->skyline.assign(1, {0, 0, width});
+}
+
+bool SkylinePacker::fits(const size_t index, const int width, const int height, int &y) const {
+    const int x = this->skyline[index].x;
+    if (x + width > this->width) {
+        return false;
+    }
+
+    // The rectangle rests on the highest segment it spans
+    y = 0;
+    int remaining = width;
+    for (size_t i = index; remaining > 0; i++) {
+        y = max(y, this->skyline[i].y);
+        if (y + height > this->height) {
+            return false;
+        }
+        remaining -= this->skyline[i].width;
+    }
+    return true;
+}
+
+bool SkylinePacker::insert(const int width, const int height, AtlasRect &rect) {
+    int bestTop = INT_MAX;
+    int bestWidth = INT_MAX;
+    size_t bestIndex = 0;
+    for (size_t i = 0; i < this->skyline.size(); i++) {
+        int y = 0;
+        if (not this->fits(i, width, height, y)) {
+            continue;
+        }
+        const int top = y + height;
+        if (top < bestTop || (top == bestTop && this->skyline[i].width < bestWidth)) {
+            bestTop = top;
+            bestWidth = this->skyline[i].width;
+            bestIndex = i;
+            rect = {this->skyline[i].x, y, width, height};
+        }
+    }
+    if (bestTop == INT_MAX) {
+        return false;
+    }
+
+    this->place(bestIndex, rect);
+    return true;
+}
+
+void SkylinePacker::place(const size_t index, const AtlasRect &rect) {
+    auto &skyline = this->skyline;
+    skyline.insert(skyline.begin() + static_cast<ptrdiff_t>(index), {rect.x, rect.y + rect.height, rect.width});
+
+    // The segments the rectangle covers are cut down, or removed when it covers them whole
+    for (size_t i = index + 1; i < skyline.size();) {
+        const Segment &previous = skyline[i - 1];
+        const int overlap = previous.x + previous.width - skyline[i].x;
+        if (overlap <= 0) {
+            break;
+        }
+        if (overlap < skyline[i].width) {
+            skyline[i].x += overlap;
+            skyline[i].width -= overlap;
+            break;
+        }
+        skyline.erase(skyline.begin() + static_cast<ptrdiff_t>(i));
+    }
+
+    // Neighbours at the same height become one segment
+    for (size_t i = 1; i < skyline.size();) {
+        if (skyline[i - 1].y == skyline[i].y) {
+            skyline[i - 1].width += skyline[i].width;
+            skyline.erase(skyline.begin() + static_cast<ptrdiff_t>(i));
+        } else {
+            i++;
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#ifndef OPENGL_TEST_ATLASPACKER_H
+#define OPENGL_TEST_ATLASPACKER_H
+
+#include <cstddef>
+#include <vector>
+
+struct AtlasRect {
+    int x{};
+    int y{};
+    int width{};
+    int height{};
+};
+
+/**
+ * Packs rectangles into a fixed size page with the skyline bottom-left heuristic.
+ *
+ * The page is described by its skyline, the top edge of everything placed so far as a list of
+ * horizontal segments. A rectangle goes where its top ends up the lowest, the narrowest segment
+ * wins ties. Space under the skyline is never reused, which wastes a little room but keeps
+ * insertion linear in the number of segments. Packing taller rectangles first helps a lot.
+ */
+class SkylinePacker {
+public:
+    struct Segment {
+        int x{};
+        int y{};
+        int width{};
+    };
+
+    int width{};
+    int height{};
+    std::vector<Segment> skyline;
+
+    void init(int width, int height);
+
+    // False when the rectangle doesn't fit anywhere in the page
+    bool insert(int width, int height, AtlasRect &rect);
+
+private:
+    // Lowest y a rectangle can sit at with its left edge on segment index, false when it sticks out
+    bool fits(size_t index, int width, int height, int &y) const;
+
+    void place(size_t index, const AtlasRect &rect);
+};
+
+
+#endif //OPENGL_TEST_ATLASPACKER_H
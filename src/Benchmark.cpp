@@ -0,0 +1,171 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+#include "SDL3/SDL_log.h"
+
+using namespace std;
+
+const char *frameStageName(const FrameStage stage) {
+    switch (stage) {
+        case FrameStage::Upload: return "upload";
+        case FrameStage::Clear: return "clear";
+        case FrameStage::Draw: return "draw";
+        case FrameStage::Swap: return "swap";
+        default: return "unknown";
+    }
+}
+
+/**
+ * Nearest-rank percentile of already sorted samples
+ */
+static double percentile(const vector<double> &sorted, const double p) {
+    const auto rank = static_cast<size_t>(ceil(p / 100.0 * static_cast<double>(sorted.size())));
+    return sorted[clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+TimingSummary summarize(vector<double> samples) {
+    if (samples.empty()) {
+        return {};
+    }
+
+    ranges::sort(samples);
+    return {
+        .min = samples.front(),
+        .avg = accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size()),
+        .p50 = percentile(samples, 50),
+        .p95 = percentile(samples, 95),
+        .p99 = percentile(samples, 99),
+        .max = samples.back(),
+    };
+}
+
+void Benchmark::begin(const uint64_t frameCount) {
+    this->frameTarget = frameCount;
+    this->framesSeen = 0;
+    this->frames.clear();
+    this->frames.reserve(frameCount);
+    this->gpuFrames.clear();
+    this->gpuFrames.reserve(frameCount);
+    this->nextGpuFrame = warmupFrames;
+}
+
+bool Benchmark::active() const {
+    return this->frameTarget != 0;
+}
+
+bool Benchmark::finished() const {
+    return this->active() && this->frames.size() >= this->frameTarget;
+}
+
+void Benchmark::record(const FrameTimings &timings) {
+    if (not this->active() || this->finished()) {
+        return;
+    }
+
+    if (this->framesSeen++ < warmupFrames) {
+        return;
+    }
+    this->frames.push_back(timings);
+}
+
+void Benchmark::recordGpu(const uint64_t frameNumber, const FrameTimings &timings) {
+    if (not this->active() || frameNumber < this->nextGpuFrame || this->gpuFrames.size() >= this->frameTarget) {
+        return;
+    }
+
+    this->nextGpuFrame = frameNumber + 1;
+    this->gpuFrames.push_back(timings);
+}
+
+// Returns the samples of one stage, or of the whole frame when stage is FrameStage::Count
+static vector<double> collect(const vector<FrameTimings> &frames, const FrameStage stage) {
+    vector<double> samples;
+    samples.reserve(frames.size());
+    for (const auto &frame: frames) {
+        samples.push_back(stage == FrameStage::Count ? frame.total : frame.stages[static_cast<size_t>(stage)]);
+    }
+    return samples;
+}
+
+static string summaryToJson(const TimingSummary &summary) {
+    char buffer[256];
+    snprintf(
+        buffer, sizeof(buffer),
+        R"({"min": %.6f, "avg": %.6f, "p50": %.6f, "p95": %.6f, "p99": %.6f, "max": %.6f})",
+        summary.min, summary.avg, summary.p50, summary.p95, summary.p99, summary.max
+    );
+    return buffer;
+}
+
+static string escapeJson(const string &text) {
+    string escaped;
+    for (const char c: text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+static string stagesToJson(const vector<FrameTimings> &frames) {
+    string json = R"({"frames": )" + to_string(frames.size()) + ", ";
+    for (size_t i = 0; i < frameStageCount; i++) {
+        const auto stage = static_cast<FrameStage>(i);
+        json += "\"" + string(frameStageName(stage)) + "\": " + summaryToJson(summarize(collect(frames, stage)));
+        json += ", ";
+    }
+    json += R"("frame": )" + summaryToJson(summarize(collect(frames, FrameStage::Count))) + "}";
+    return json;
+}
+
+string Benchmark::toJson(const string &rendererName) const {
+    string json = R"({"renderer": ")" + escapeJson(rendererName) + "\", ";
+    json += R"("frames": )" + to_string(this->frames.size()) + ", ";
+    json += R"("warmupFrames": )" + to_string(warmupFrames) + ", ";
+    json += R"("unit": "ms", )";
+    json += R"("cpu": )" + stagesToJson(this->frames) + ", ";
+    json += R"("gpu": )" + stagesToJson(this->gpuFrames) + "}";
+    return json;
+}
+
+static void logTable(const char *title, const vector<FrameTimings> &frames) {
+    SDL_Log("%s, %zu frames (ms)", title, frames.size());
+    SDL_Log("%-8s %10s %10s %10s %10s %10s %10s", "stage", "min", "avg", "p50", "p95", "p99", "max");
+    for (size_t i = 0; i <= frameStageCount; i++) {
+        const auto stage = static_cast<FrameStage>(i);
+        const auto summary = summarize(collect(frames, stage));
+        SDL_Log(
+            "%-8s %10.4f %10.4f %10.4f %10.4f %10.4f %10.4f",
+            stage == FrameStage::Count ? "frame" : frameStageName(stage),
+            summary.min, summary.avg, summary.p50, summary.p95, summary.p99, summary.max
+        );
+    }
+}
+
+bool Benchmark::report(const string &rendererName, const char *jsonPath) const {
+    SDL_Log("Benchmark on %s", rendererName.c_str());
+    logTable("CPU time", this->frames);
+    logTable("GPU time", this->gpuFrames);
+
+    const string json = this->toJson(rendererName);
+    if (not jsonPath) {
+        puts(json.c_str());
+        return true;
+    }
+
+    FILE *file = fopen(jsonPath, "w");
+    if (not file) {
+        SDL_LogError(0, "Benchmark error: Could not open %s for writing", jsonPath);
+        return false;
+    }
+    fputs(json.c_str(), file);
+    fputc('\n', file);
+    fclose(file);
+    SDL_Log("Benchmark: JSON report written to %s", jsonPath);
+    return true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#ifndef OPENGL_TEST_BENCHMARK_H
+#define OPENGL_TEST_BENCHMARK_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The stages of RenderEngine::render we time separately
+enum class FrameStage {
+    // Shader swaps and texture uploads, before anything is drawn
+    Upload,
+    Clear,
+    Draw,
+    Swap,
+    Count,
+};
+
+constexpr size_t frameStageCount = static_cast<size_t>(FrameStage::Count);
+
+const char *frameStageName(FrameStage stage);
+
+// CPU time spent in each stage of a frame, in milliseconds
+struct FrameTimings {
+    std::array<double, frameStageCount> stages{};
+    double total{};
+};
+
+struct TimingSummary {
+    double min{};
+    double avg{};
+    double p50{};
+    double p95{};
+    double p99{};
+    double max{};
+};
+
+TimingSummary summarize(std::vector<double> samples);
+
+/**
+ * Collects the timings of a fixed number of frames (--bench N) and reports their distribution.
+ * The first few frames are rendered but not recorded, so that driver warm-up doesn't skew the results.
+ * CPU timings come from RenderEngine::frameTimings, GPU timings from its GpuTimer.
+ */
+class Benchmark {
+public:
+    static constexpr uint64_t warmupFrames = 10;
+
+    uint64_t frameTarget{};
+    uint64_t framesSeen{};
+    std::vector<FrameTimings> frames;
+    // GPU timings arrive a few frames late, so they are recorded separately along with their frame number
+    std::vector<FrameTimings> gpuFrames;
+    uint64_t nextGpuFrame = warmupFrames;
+
+    void begin(uint64_t frameCount);
+
+    bool active() const;
+
+    bool finished() const;
+
+    void record(const FrameTimings &timings);
+
+    void recordGpu(uint64_t frameNumber, const FrameTimings &timings);
+
+    // Logs a human readable table and writes the JSON report to jsonPath, or to stdout if it is null
+    bool report(const std::string &rendererName, const char *jsonPath) const;
+
+    std::string toJson(const std::string &rendererName) const;
+};
+
+
+#endif //OPENGL_TEST_BENCHMARK_H
@@ -0,0 +1,244 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+
+#include "BlockFormat.h"
+
+using namespace std;
+
+// What each 8 byte half of a block holds
+enum class BlockPart {
+    None,
+    // BC1 style endpoints and 2 bit indices, one byte per row
+    Color,
+    // BC2 explicit 4 bit alpha, two bytes per row
+    ExplicitAlpha,
+    // BC3/BC4 alpha endpoints and 3 bit indices, 12 bits per row
+    InterpolatedAlpha,
+};
+
+struct BlockLayout {
+    BlockPart first;
+    BlockPart second;
+};
+
+static bool layoutOf(const uint32_t internalFormat, BlockLayout &layout) {
+    switch (internalFormat) {
+        case formatBc1:
+        case formatBc1Alpha:
+        case formatBc1Srgb:
+        case formatBc1AlphaSrgb: layout = {BlockPart::Color, BlockPart::None};
+            return true;
+        case formatBc2:
+        case formatBc2Srgb: layout = {BlockPart::ExplicitAlpha, BlockPart::Color};
+            return true;
+        case formatBc3:
+        case formatBc3Srgb: layout = {BlockPart::InterpolatedAlpha, BlockPart::Color};
+            return true;
+        case formatBc4: layout = {BlockPart::InterpolatedAlpha, BlockPart::None};
+            return true;
+        case formatBc5: layout = {BlockPart::InterpolatedAlpha, BlockPart::InterpolatedAlpha};
+            return true;
+        default: return false;
+    }
+}
+
+using Pixels = array<array<unsigned char, 4>, 16>;
+
+/**
+ * Outside of BC1 the color half always uses 4 colors. In BC1, color0 <= color1 selects 3 colors and
+ * black, which is transparent only in the alpha variants.
+ */
+static void decodeColor(const unsigned char *block, const bool bc1, const bool transparentBlack, Pixels &pixels) {
+    const uint64_t color0 = readLittleEndian(block, 2), color1 = readLittleEndian(block + 2, 2);
+    const uint64_t indices = readLittleEndian(block + 4, 4);
+    const auto end0 = from565(color0), end1 = from565(color1);
+
+    array<array<int, 4>, 4> palette{};
+    for (int c = 0; c < 3; c++) {
+        palette[0][c] = end0[c];
+        palette[1][c] = end1[c];
+        if (not bc1 || color0 > color1) {
+            palette[2][c] = (2 * end0[c] + end1[c]) / 3;
+            palette[3][c] = (end0[c] + 2 * end1[c]) / 3;
+        } else {
+            palette[2][c] = (end0[c] + end1[c]) / 2;
+        }
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+    if (bc1 && color0 <= color1 && transparentBlack) {
+        palette[3][3] = 0;
+    }
+
+    for (int i = 0; i < 16; i++) {
+        const auto &color = palette[indices >> (2 * i) & 3];
+        for (int c = 0; c < 4; c++) {
+            pixels[i][c] = static_cast<unsigned char>(color[c]);
+        }
+    }
+}
+
+static void decodeExplicitAlpha(const unsigned char *block, Pixels &pixels) {
+    const uint64_t alphas = readLittleEndian(block, 8);
+    for (int i = 0; i < 16; i++) {
+        pixels[i][3] = static_cast<unsigned char>((alphas >> (4 * i) & 15) * 17);
+    }
+}
+
+static void decodeInterpolatedAlpha(const unsigned char *block, Pixels &pixels) {
+    const int alpha0 = block[0], alpha1 = block[1];
+    array<int, 8> palette{alpha0, alpha1};
+    if (alpha0 > alpha1) {
+        for (int i = 1; i < 7; i++) {
+            palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+        }
+    } else {
+        for (int i = 1; i < 5; i++) {
+            palette[i + 1] = ((5 - i) * alpha0 + i * alpha1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    const uint64_t indices = readLittleEndian(block + 2, 6);
+    for (int i = 0; i < 16; i++) {
+        pixels[i][3] = static_cast<unsigned char>(palette[indices >> (3 * i) & 7]);
+    }
+}
+
+bool canDecompress(const uint32_t internalFormat) {
+    const TextureFormatInfo *info = formatInfo(internalFormat);
+    return info && info->compression == TextureCompression::S3tc;
+}
+
+bool decompress(const CookedTexture &texture, const span<const unsigned char> bytes,
+                CookedTexture &decoded, vector<unsigned char> &pixels) {
+    BlockLayout layout{};
+    if (not canDecompress(texture.internalFormat) || not layoutOf(texture.internalFormat, layout)) {
+        return false;
+    }
+    const bool bc1 = layout.first == BlockPart::Color;
+    const bool transparentBlack = texture.internalFormat == formatBc1Alpha || texture.internalFormat == formatBc1AlphaSrgb;
+    const size_t bytesPerBlock = blockSize(texture.internalFormat);
+
+    decoded = CookedTexture{};
+    decoded.internalFormat = formatInfo(texture.internalFormat)->srgb ? formatSrgb8Alpha8 : formatRgba8;
+    decoded.format = pixelFormatRgba;
+    decoded.type = pixelTypeUnsignedByte;
+    decoded.width = texture.width;
+    decoded.height = texture.height;
+    decoded.topDown = texture.topDown;
+
+    size_t total = 0;
+    for (const auto &level: texture.levels) {
+        total += imageSize(decoded.internalFormat, level.width, level.height);
+    }
+    pixels.resize(total);
+
+    size_t offset = 0;
+    for (const auto &level: texture.levels) {
+        const size_t size = imageSize(decoded.internalFormat, level.width, level.height);
+        decoded.levels.push_back({level.width, level.height, offset, size});
+        unsigned char *out = pixels.data() + offset;
+        offset += size;
+
+        const int blocksWide = (level.width + 3) / 4;
+        const int blocksHigh = (level.height + 3) / 4;
+        for (int blockY = 0; blockY < blocksHigh; blockY++) {
+            for (int blockX = 0; blockX < blocksWide; blockX++) {
+                const unsigned char *block = bytes.data() + level.offset + (static_cast<size_t>(blockY) * blocksWide + blockX) * bytesPerBlock;
+                Pixels decodedBlock{};
+                if (bc1) {
+                    decodeColor(block, true, transparentBlack, decodedBlock);
+                } else {
+                    decodeColor(block + 8, false, false, decodedBlock);
+                    if (layout.first == BlockPart::ExplicitAlpha) {
+                        decodeExplicitAlpha(block, decodedBlock);
+                    } else {
+                        decodeInterpolatedAlpha(block, decodedBlock);
+                    }
+                }
+
+                // Blocks hanging over the edge of small or odd sized levels are cropped
+                for (int i = 0; i < 16; i++) {
+                    const int x = blockX * 4 + i % 4;
+                    const int y = blockY * 4 + i / 4;
+                    if (x < level.width && y < level.height) {
+                        memcpy(out + (static_cast<size_t>(y) * level.width + x) * 4, decodedBlock[i].data(), 4);
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Reverses the first rows rows of one half of a block, the rows below are padding
+static void flipBlockPart(unsigned char *part, const BlockPart kind, const int rows) {
+    switch (kind) {
+        case BlockPart::None: return;
+        case BlockPart::Color: reverse(part + 4, part + 4 + rows);
+            return;
+        case BlockPart::ExplicitAlpha:
+            for (int row = 0; row < rows / 2; row++) {
+                swap_ranges(part + row * 2, part + row * 2 + 2, part + (rows - 1 - row) * 2);
+            }
+            return;
+        case BlockPart::InterpolatedAlpha: {
+            const uint64_t indices = readLittleEndian(part + 2, 6);
+            uint64_t flipped = indices;
+            for (int row = 0; row < rows; row++) {
+                const uint64_t bits = indices >> (12 * row) & 0xfff;
+                const int target = rows - 1 - row;
+                flipped = (flipped & ~(uint64_t{0xfff} << (12 * target))) | bits << (12 * target);
+            }
+            writeLittleEndian(part + 2, flipped, 6);
+            return;
+        }
+    }
+}
+
+bool flipVertically(const CookedTexture &texture, const span<unsigned char> bytes, const char *&failureReason) {
+    if (not texture.compressed()) {
+        for (const auto &level: texture.levels) {
+            const size_t rowSize = static_cast<size_t>(level.width) * 4;
+            unsigned char *data = bytes.data() + level.offset;
+            for (int row = 0; row < level.height / 2; row++) {
+                swap_ranges(data + row * rowSize, data + (row + 1) * rowSize, data + (level.height - 1 - row) * rowSize);
+            }
+        }
+        return true;
+    }
+
+    BlockLayout layout{};
+    if (not layoutOf(texture.internalFormat, layout)) {
+        failureReason = "blocks of this format can't be flipped";
+        return false;
+    }
+    const size_t bytesPerBlock = blockSize(texture.internalFormat);
+
+    for (const auto &level: texture.levels) {
+        if (level.height > 4 && level.height % 4 != 0) {
+            failureReason = "compressed levels can only be flipped when their height is a multiple of 4";
+            return false;
+        }
+        const int rows = min(level.height, 4);
+        const int blocksWide = (level.width + 3) / 4;
+        const int blocksHigh = (level.height + 3) / 4;
+        const size_t rowSize = blocksWide * bytesPerBlock;
+        unsigned char *data = bytes.data() + level.offset;
+
+        for (int blockY = 0; blockY < blocksHigh / 2; blockY++) {
+            swap_ranges(data + blockY * rowSize, data + (blockY + 1) * rowSize, data + (blocksHigh - 1 - blockY) * rowSize);
+        }
+        for (size_t block = 0; block < static_cast<size_t>(blocksWide) * blocksHigh; block++) {
+            unsigned char *blockData = data + block * bytesPerBlock;
+            flipBlockPart(blockData, layout.first, rows);
+            flipBlockPart(blockData + 8, layout.second, rows);
+        }
+    }
+    return true;
+}
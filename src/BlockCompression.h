@@ -0,0 +1,35 @@
+#pragma once
+
+#ifndef OPENGL_TEST_BLOCKCOMPRESSION_H
+#define OPENGL_TEST_BLOCKCOMPRESSION_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "TextureFile.h"
+
+/*
+ * CPU fallbacks for texture files the driver can't take as they are. Only the S3TC formats (BC1, BC2, BC3
+ * and their sRGB variants) can be decoded: RGTC is core in every context we create, and BC7 and ETC2
+ * decoders would be far bigger than what falling back to the source image costs.
+ */
+
+bool canDecompress(uint32_t internalFormat);
+
+/**
+ * Decodes every level of texture into RGBA8 (SRGB8_ALPHA8 for sRGB formats), back to back in pixels.
+ * decoded describes the result, its level offsets are relative to pixels.
+ */
+bool decompress(const CookedTexture &texture, std::span<const unsigned char> bytes,
+                CookedTexture &decoded, std::vector<unsigned char> &pixels);
+
+/**
+ * Mirrors every level in place, so that files storing the top row first match GL's bottom row first.
+ * Compressed levels are flipped block by block, which only works for BC1-5 and heights that are a
+ * multiple of 4 (or a single row of blocks). failureReason is set when it returns false.
+ */
+bool flipVertically(const CookedTexture &texture, std::span<unsigned char> bytes, const char *&failureReason);
+
+
+#endif //OPENGL_TEST_BLOCKCOMPRESSION_H
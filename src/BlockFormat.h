@@ -0,0 +1,36 @@
+#pragma once
+
+#ifndef OPENGL_TEST_BLOCKFORMAT_H
+#define OPENGL_TEST_BLOCKFORMAT_H
+
+#include <array>
+#include <cstdint>
+
+/*
+ * Bit level helpers of the S3TC block layout, shared by the decoder (BlockCompression) and the
+ * encoder in tools/texture_cooker.cpp so that both read endpoints and indices the same way.
+ */
+
+// Block fields are little endian and not aligned, bytes is at most 8
+constexpr uint64_t readLittleEndian(const unsigned char *data, const int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        value = value << 8 | data[i];
+    }
+    return value;
+}
+
+constexpr void writeLittleEndian(unsigned char *data, uint64_t value, const int bytes) {
+    for (int i = 0; i < bytes; i++, value >>= 8) {
+        data[i] = static_cast<unsigned char>(value);
+    }
+}
+
+// Expands an RGB565 endpoint to 8 bits per channel, replicating the high bits into the low ones
+constexpr std::array<int, 3> from565(const uint64_t color) {
+    const int r = static_cast<int>(color >> 11 & 31), g = static_cast<int>(color >> 5 & 63), b = static_cast<int>(color & 31);
+    return {r << 3 | r >> 2, g << 2 | g >> 4, b << 3 | b >> 2};
+}
+
+
+#endif //OPENGL_TEST_BLOCKFORMAT_H
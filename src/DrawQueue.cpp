@@ -0,0 +1,95 @@
+#include "DrawQueue.h"
+
+#include <algorithm>
+#include <array>
+
+#include "glbinding/gl33core/gl.h"
+
+using namespace std;
+using namespace gl33core;
+
+static uint64_t bits(const uint64_t value, const int width) {
+    return value & ((1ull << width) - 1);
+}
+
+uint64_t DrawQueue::makeKey(
+    const RenderPass pass,
+    const unsigned int program, const unsigned int texture, const unsigned int vertexArray,
+    const float depth
+) {
+    constexpr uint64_t depthMax = (1ull << 20) - 1;
+    const auto quantizedDepth = static_cast<uint64_t>(clamp(depth, 0.0f, 1.0f) * static_cast<float>(depthMax));
+
+    const uint64_t state = bits(program, 12) << 28 | bits(texture, 16) << 12 | bits(vertexArray, 12);
+    if (pass == RenderPass::Transparent) {
+        return bits(static_cast<uint64_t>(pass), 4) << 60 | (depthMax - quantizedDepth) << 40 | state;
+    }
+    return bits(static_cast<uint64_t>(pass), 4) << 60 | state << 20 | quantizedDepth;
+}
+
+void DrawQueue::clear() {
+    this->packets.clear();
+}
+
+void DrawQueue::submit(DrawPacket packet, const float depth) {
+    packet.key = makeKey(packet.pass, packet.program, packet.texture, packet.vertexArray, depth);
+    this->packets.push_back(packet);
+}
+
+void DrawQueue::sort() {
+    const size_t count = this->packets.size();
+    this->keys.resize(count);
+    this->order.resize(count);
+    this->keysScratch.resize(count);
+    this->orderScratch.resize(count);
+
+    uint64_t differingBits = 0;
+    for (size_t i = 0; i < count; i++) {
+        this->keys[i] = this->packets[i].key;
+        this->order[i] = static_cast<uint32_t>(i);
+        differingBits |= this->keys[i] ^ this->keys[0];
+    }
+
+    // LSD radix sort, one byte per pass, skipping the bytes that are the same in every key
+    for (int shift = 0; shift < 64; shift += 8) {
+        if (((differingBits >> shift) & 0xff) == 0) {
+            continue;
+        }
+
+        array<uint32_t, 256> offsets{};
+        for (const uint64_t key: this->keys) {
+            offsets[(key >> shift) & 0xff]++;
+        }
+        uint32_t total = 0;
+        for (auto &offset: offsets) {
+            const uint32_t bucketSize = offset;
+            offset = total;
+            total += bucketSize;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t destination = offsets[(this->keys[i] >> shift) & 0xff]++;
+            this->keysScratch[destination] = this->keys[i];
+            this->orderScratch[destination] = this->order[i];
+        }
+        this->keys.swap(this->keysScratch);
+        this->order.swap(this->orderScratch);
+    }
+}
+
+void DrawQueue::execute(GLStateCache &state) const {
+    for (const uint32_t index: this->order) {
+        const auto &packet = this->packets[index];
+
+        state.setBlend(packet.pass == RenderPass::Transparent, BlendMode::Alpha);
+        state.useProgram(packet.program);
+        state.bindTexture(0, packet.textureTarget, packet.texture);
+
+        if (packet.batch) {
+            packet.batch->draw(state, packet.instances);
+        } else {
+            state.bindVertexArray(packet.vertexArray);
+            glDrawElements(GL_TRIANGLES, packet.indexCount, GL_UNSIGNED_INT, 0);
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef OPENGL_TEST_DRAWQUEUE_H
+#define OPENGL_TEST_DRAWQUEUE_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "GLStateCache.h"
+#include "SpriteBatch.h"
+
+enum class RenderPass : uint8_t {
+    Opaque,
+    Transparent,
+};
+
+struct DrawPacket {
+    uint64_t key{};
+    RenderPass pass = RenderPass::Opaque;
+    unsigned int program{};
+    unsigned int texture{};
+    TextureTarget textureTarget = TextureTarget::Texture2D;
+    unsigned int vertexArray{};
+    int indexCount{};
+    // When set, the packet draws these instances through the batch instead of vertexArray
+    SpriteBatch *batch{};
+    std::span<const SpriteInstance> instances;
+};
+
+/**
+ * Collects the draws of a frame in any order, then sorts them by a 64-bit key so that
+ * submission changes as little state as possible.
+ *
+ * Opaque key:      pass (4) | program (12) | texture (16) | vertex array (12) | depth (20)
+ * Transparent key: pass (4) | inverted depth (20) | program (12) | texture (16) | vertex array (12)
+ *
+ * Opaque draws are grouped by state then sorted front to back, transparent ones must be drawn
+ * back to front so depth comes first. Object names are truncated to their field, a collision only
+ * costs an extra state change since the packet keeps the full names.
+ */
+class DrawQueue {
+public:
+    std::vector<DrawPacket> packets;
+
+    // Radix sort buffers, kept between frames so sorting doesn't allocate
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> order;
+    std::vector<uint64_t> keysScratch;
+    std::vector<uint32_t> orderScratch;
+
+    static uint64_t makeKey(RenderPass pass, unsigned int program, unsigned int texture, unsigned int vertexArray, float depth);
+
+    void clear();
+
+    // depth is in [0, 1], 0 being the closest to the camera
+    void submit(DrawPacket packet, float depth = 0.0f);
+
+    // Sorts the packets by key, keeps the submission order of packets with equal keys
+    void sort();
+
+    // Issues every packet in sorted order
+    void execute(GLStateCache &state) const;
+};
+
+
+#endif //OPENGL_TEST_DRAWQUEUE_H
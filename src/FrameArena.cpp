@@ -0,0 +1,61 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <bit>
+
+#include "SDL3/SDL_log.h"
+
+using namespace std;
+
+void FrameArena::init(const size_t regionCapacity) {
+    for (auto &region: this->regions) {
+        region.memory = make_unique<byte[]>(regionCapacity);
+        region.capacity = regionCapacity;
+        region.used = 0;
+    }
+}
+
+void *FrameArena::allocate(const size_t slot, const size_t size, const size_t alignment) {
+    Region &region = this->regions[slot];
+
+    const auto base = reinterpret_cast<uintptr_t>(region.memory.get());
+    const size_t offset = ((base + region.used + alignment - 1) & ~(alignment - 1)) - base;
+    if (offset + size <= region.capacity) {
+        region.used = offset + size;
+        return region.memory.get() + offset;
+    }
+
+    // new[] only guarantees the default alignment, so we keep room to align by hand
+    auto &block = region.overflow.emplace_back(make_unique<byte[]>(size + alignment));
+    region.overflowBytes += size + alignment;
+    const auto address = reinterpret_cast<uintptr_t>(block.get());
+    return block.get() + (((address + alignment - 1) & ~(alignment - 1)) - address);
+}
+
+void FrameArena::reset(const size_t slot) {
+    Region &region = this->regions[slot];
+
+    const size_t frameBytes = region.used + region.overflowBytes;
+    this->frames++;
+    this->lastFrameBytes = frameBytes;
+    this->peakFrameBytes = max(this->peakFrameBytes, frameBytes);
+
+    if (region.overflowBytes != 0) {
+        // Grow so that the next frame of the same size fits
+        this->overflowFrames++;
+        region.capacity = bit_ceil(frameBytes);
+        region.memory = make_unique<byte[]>(region.capacity);
+        region.overflow.clear();
+        region.overflowBytes = 0;
+        SDL_Log("Frame arena: region %zu grown to %zu bytes", slot, region.capacity);
+    }
+    region.used = 0;
+}
+
+void FrameArena::logStats() const {
+    SDL_Log(
+        "Frame arena: %llu frames, peak %zu bytes per frame, last %zu bytes, %llu frames overflowed",
+        (unsigned long long) this->frames, this->peakFrameBytes, this->lastFrameBytes,
+        (unsigned long long) this->overflowFrames
+    );
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#ifndef OPENGL_TEST_FRAMEARENA_H
+#define OPENGL_TEST_FRAMEARENA_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Bump allocator for data that only lives for a frame, so that building a frame never hits malloc.
+ *
+ * It has one region per TripleBuffer slot: whatever the main thread allocates while filling a
+ * snapshot lives in the region of that slot, and stays alive until the slot comes back from
+ * publish(), at which point nobody can read it anymore and the region is reset.
+ * A region that runs out falls back to the heap for the rest of the frame, then grows on reset.
+ */
+class FrameArena {
+public:
+    static constexpr size_t regionCount = 3;
+
+    struct Region {
+        std::unique_ptr<std::byte[]> memory;
+        size_t capacity{};
+        size_t used{};
+        // Blocks allocated after the region ran out, freed on reset
+        std::vector<std::unique_ptr<std::byte[]>> overflow;
+        size_t overflowBytes{};
+    };
+
+    std::array<Region, regionCount> regions;
+
+    // Statistics, updated on reset
+    uint64_t frames{};
+    size_t lastFrameBytes{};
+    size_t peakFrameBytes{};
+    uint64_t overflowFrames{};
+
+    void init(size_t regionCapacity);
+
+    // Memory stays valid until reset(slot), a region must only be used by one thread at a time
+    void *allocate(size_t slot, size_t size, size_t alignment);
+
+    // Elements are left uninitialized and never destroyed
+    template<typename T>
+    std::span<T> allocateArray(const size_t slot, const size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "Frame arena memory is never destructed");
+        if (count == 0) {
+            return {};
+        }
+        return {static_cast<T *>(this->allocate(slot, sizeof(T) * count, alignof(T))), count};
+    }
+
+    void reset(size_t slot);
+
+    void logStats() const;
+};
+
+
+#endif //OPENGL_TEST_FRAMEARENA_H
@@ -0,0 +1,24 @@
+#pragma once
+
+#ifndef OPENGL_TEST_FRAMESNAPSHOT_H
+#define OPENGL_TEST_FRAMESNAPSHOT_H
+
+#include <cstdint>
+#include <span>
+
+#include "SpriteBatch.h"
+
+// Everything the render thread needs to draw a frame, produced by the main thread
+struct FrameSnapshot {
+    uint64_t frameNumber{};
+    // Seconds since startup
+    float time{};
+    bool wireframe = false;
+    // Size of the drawable in pixels
+    int width{};
+    int height{};
+    // Allocated from the FrameArena region of the snapshot's slot
+    std::span<const SpriteInstance> sprites;
+};
+
+#endif //OPENGL_TEST_FRAMESNAPSHOT_H
@@ -0,0 +1,212 @@
+#include "GLStateCache.h"
+
+#include "glbinding/gl33core/gl.h"
+
+using namespace std;
+using namespace gl33core;
+
+static GLenum glTarget(const BufferTarget target) {
+    switch (target) {
+        case BufferTarget::Array: return GL_ARRAY_BUFFER;
+        case BufferTarget::ElementArray: return GL_ELEMENT_ARRAY_BUFFER;
+        case BufferTarget::PixelUnpack: return GL_PIXEL_UNPACK_BUFFER;
+        default: return GL_UNIFORM_BUFFER;
+    }
+}
+
+static GLenum glTarget(const TextureTarget target) {
+    switch (target) {
+        case TextureTarget::Texture2DArray: return GL_TEXTURE_2D_ARRAY;
+        default: return GL_TEXTURE_2D;
+    }
+}
+
+GLStateCache::GLStateCache() {
+    this->invalidate();
+}
+
+void GLStateCache::invalidate() {
+    this->program = unknown;
+    this->vertexArray = unknown;
+    this->buffers.fill(unknown);
+    this->uniformRanges.fill({unknown});
+    this->activeUnit = unknown;
+    for (auto &unit: this->textures) {
+        unit.fill(unknown);
+    }
+    this->polygonMode = -1;
+    this->blend = -1;
+    this->blendMode = -1;
+    this->depthTest = -1;
+    this->depthFunc = -1;
+    this->depthWrite = -1;
+    this->viewport = {-1, -1, -1, -1};
+}
+
+bool GLStateCache::changed(unsigned int &current, const unsigned int value) {
+    if (current == value) {
+        this->stats.skipped++;
+        return false;
+    }
+    current = value;
+    this->stats.issued++;
+    return true;
+}
+
+bool GLStateCache::changed(int &current, const int value) {
+    if (current == value) {
+        this->stats.skipped++;
+        return false;
+    }
+    current = value;
+    this->stats.issued++;
+    return true;
+}
+
+void GLStateCache::useProgram(const unsigned int id) {
+    if (this->changed(this->program, id)) {
+        glUseProgram(id);
+    }
+}
+
+void GLStateCache::bindVertexArray(const unsigned int id) {
+    if (this->changed(this->vertexArray, id)) {
+        glBindVertexArray(id);
+        // The element array binding is part of the vertex array state
+        this->buffers[static_cast<size_t>(BufferTarget::ElementArray)] = unknown;
+    }
+}
+
+void GLStateCache::bindBuffer(const BufferTarget target, const unsigned int id) {
+    if (this->changed(this->buffers[static_cast<size_t>(target)], id)) {
+        glBindBuffer(glTarget(target), id);
+    }
+}
+
+void GLStateCache::bindUniformBuffer(const unsigned int index, const unsigned int id, const size_t offset, const size_t size) {
+    // Binding points past the shadowed ones aren't cached, GL reports the ones the driver doesn't have
+    if (index < uniformBindings) {
+        auto &range = this->uniformRanges[index];
+        if (range.buffer == id && range.offset == offset && range.size == size) {
+            this->stats.skipped++;
+            return;
+        }
+        range = {id, offset, size};
+    }
+
+    this->buffers[static_cast<size_t>(BufferTarget::Uniform)] = id;
+    this->stats.issued++;
+    glBindBufferRange(GL_UNIFORM_BUFFER, index, id, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+}
+
+void GLStateCache::setActiveUnit(const unsigned int unit) {
+    if (this->changed(this->activeUnit, unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+}
+
+void GLStateCache::bindTexture(const unsigned int unit, const TextureTarget target, const unsigned int id) {
+    auto &bound = this->textures[unit][static_cast<size_t>(target)];
+    if (bound == id) {
+        this->stats.skipped++;
+        return;
+    }
+
+    this->setActiveUnit(unit);
+    bound = id;
+    this->stats.issued++;
+    glBindTexture(glTarget(target), id);
+}
+
+void GLStateCache::forgetTexture(const unsigned int id) {
+    for (auto &unit: this->textures) {
+        for (auto &bound: unit) {
+            if (bound == id) {
+                bound = unknown;
+            }
+        }
+    }
+}
+
+void GLStateCache::forgetBuffer(const unsigned int id) {
+    for (auto &bound: this->buffers) {
+        if (bound == id) {
+            bound = unknown;
+        }
+    }
+    for (auto &range: this->uniformRanges) {
+        if (range.buffer == id) {
+            range.buffer = unknown;
+        }
+    }
+}
+
+void GLStateCache::setPolygonMode(const PolygonMode mode) {
+    if (this->changed(this->polygonMode, static_cast<int>(mode))) {
+        glPolygonMode(GL_FRONT_AND_BACK, mode == PolygonMode::Line ? GL_LINE : GL_FILL);
+    }
+}
+
+void GLStateCache::setBlend(const bool enabled, const BlendMode mode) {
+    if (this->changed(this->blend, enabled)) {
+        if (enabled) {
+            glEnable(GL_BLEND);
+        } else {
+            glDisable(GL_BLEND);
+        }
+    }
+    if (not enabled) {
+        return;
+    }
+
+    if (this->changed(this->blendMode, static_cast<int>(mode))) {
+        switch (mode) {
+            case BlendMode::Alpha: glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                break;
+            case BlendMode::Premultiplied: glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+                break;
+            case BlendMode::Additive: glBlendFunc(GL_ONE, GL_ONE);
+                break;
+        }
+    }
+}
+
+void GLStateCache::setDepthTest(const bool enabled, const DepthFunc func) {
+    if (this->changed(this->depthTest, enabled)) {
+        if (enabled) {
+            glEnable(GL_DEPTH_TEST);
+        } else {
+            glDisable(GL_DEPTH_TEST);
+        }
+    }
+    if (not enabled) {
+        return;
+    }
+
+    if (this->changed(this->depthFunc, static_cast<int>(func))) {
+        switch (func) {
+            case DepthFunc::Less: glDepthFunc(GL_LESS);
+                break;
+            case DepthFunc::LessEqual: glDepthFunc(GL_LEQUAL);
+                break;
+            case DepthFunc::Always: glDepthFunc(GL_ALWAYS);
+                break;
+        }
+    }
+}
+
+void GLStateCache::setDepthWrite(const bool enabled) {
+    if (this->changed(this->depthWrite, enabled)) {
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+    }
+}
+
+void GLStateCache::setViewport(const int x, const int y, const int width, const int height) {
+    if (const array value{x, y, width, height}; value == this->viewport) {
+        this->stats.skipped++;
+        return;
+    }
+    this->viewport = {x, y, width, height};
+    this->stats.issued++;
+    glViewport(x, y, width, height);
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#ifndef OPENGL_TEST_GLSTATECACHE_H
+#define OPENGL_TEST_GLSTATECACHE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+enum class BufferTarget {
+    Array,
+    ElementArray,
+    PixelUnpack,
+    Uniform,
+    Count,
+};
+
+enum class TextureTarget {
+    Texture2D,
+    Texture2DArray,
+    Count,
+};
+
+enum class PolygonMode {
+    Fill,
+    Line,
+};
+
+enum class BlendMode {
+    // glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA)
+    Alpha,
+    // glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA)
+    Premultiplied,
+    // glBlendFunc(GL_ONE, GL_ONE)
+    Additive,
+};
+
+enum class DepthFunc {
+    Less,
+    LessEqual,
+    Always,
+};
+
+// Range of a buffer bound to an indexed binding point
+struct BufferRange {
+    unsigned int buffer{};
+    size_t offset{};
+    size_t size{};
+};
+
+struct GLStateStats {
+    uint64_t issued{};
+    uint64_t skipped{};
+};
+
+/**
+ * Shadows the GL state we change during a frame and skips the calls that wouldn't change anything.
+ * Every bind or state change of the render loop must go through it, otherwise the shadow copy
+ * goes stale: code that touches GL directly has to call invalidate() afterwards.
+ */
+class GLStateCache {
+public:
+    static constexpr size_t textureUnits = 16;
+    // GL 3.3 guarantees at least 36 uniform buffer bindings, we only track the first ones
+    static constexpr size_t uniformBindings = 16;
+    // Marks a value we don't know, so that the next call always goes through
+    static constexpr unsigned int unknown = ~0u;
+
+    unsigned int program = unknown;
+    unsigned int vertexArray = unknown;
+    std::array<unsigned int, static_cast<size_t>(BufferTarget::Count)> buffers{};
+    std::array<BufferRange, uniformBindings> uniformRanges{};
+    unsigned int activeUnit = unknown;
+    std::array<std::array<unsigned int, static_cast<size_t>(TextureTarget::Count)>, textureUnits> textures{};
+    int polygonMode = -1;
+    int blend = -1;
+    int blendMode = -1;
+    int depthTest = -1;
+    int depthFunc = -1;
+    int depthWrite = -1;
+    std::array<int, 4> viewport{};
+
+    GLStateStats stats;
+
+    GLStateCache();
+
+    // Forgets everything, the next call of each kind is always issued
+    void invalidate();
+
+    void useProgram(unsigned int id);
+
+    void bindVertexArray(unsigned int id);
+
+    void bindBuffer(BufferTarget target, unsigned int id);
+
+    // glBindBufferRange on GL_UNIFORM_BUFFER, which also changes the generic uniform buffer binding
+    void bindUniformBuffer(unsigned int index, unsigned int id, size_t offset, size_t size);
+
+    void bindTexture(unsigned int unit, TextureTarget target, unsigned int id);
+
+    // To call when deleting objects, so that a recycled name isn't mistaken for the deleted one
+    void forgetTexture(unsigned int id);
+
+    void forgetBuffer(unsigned int id);
+
+    void setPolygonMode(PolygonMode mode);
+
+    void setBlend(bool enabled, BlendMode mode = BlendMode::Alpha);
+
+    void setDepthTest(bool enabled, DepthFunc func = DepthFunc::Less);
+
+    void setDepthWrite(bool enabled);
+
+    void setViewport(int x, int y, int width, int height);
+
+private:
+    void setActiveUnit(unsigned int unit);
+
+    bool changed(unsigned int &current, unsigned int value);
+
+    bool changed(int &current, int value);
+};
+
+
+#endif //OPENGL_TEST_GLSTATECACHE_H
@@ -0,0 +1,108 @@
+#include "GpuTimer.h"
+
+#include "SDL3/SDL_log.h"
+
+#include "glbinding/gl33core/gl.h"
+
+using namespace std;
+using namespace gl33core;
+
+void GpuTimer::init() {
+    for (auto &frameQueries: this->queries) {
+        glGenQueries(static_cast<GLsizei>(frameQueries.size()), frameQueries.data());
+    }
+    this->initialized = true;
+}
+
+void GpuTimer::destroy() {
+    if (not this->initialized) {
+        return;
+    }
+
+    for (auto &frameQueries: this->queries) {
+        glDeleteQueries(static_cast<GLsizei>(frameQueries.size()), frameQueries.data());
+    }
+    this->pending.fill(false);
+    this->initialized = false;
+}
+
+bool GpuTimer::collect() {
+    bool newResult = false;
+
+    // Go through the ring from the oldest frame to the newest one, and stop at the first unfinished frame
+    for (size_t age = frameLatency; age > 0; age--) {
+        const size_t slot = (this->frameNumber + frameLatency - age) % frameLatency;
+        if (not this->pending[slot]) {
+            continue;
+        }
+
+        // The last timestamp of a frame is the last to complete
+        GLint available = 0;
+        glGetQueryObjectiv(this->queries[slot][timestampCount - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (not available) {
+            break;
+        }
+
+        array<GLuint64, timestampCount> timestamps{};
+        for (size_t i = 0; i < timestampCount; i++) {
+            glGetQueryObjectui64v(this->queries[slot][i], GL_QUERY_RESULT, &timestamps[i]);
+        }
+        this->pending[slot] = false;
+
+        for (size_t stage = 0; stage < frameStageCount; stage++) {
+            this->latest.stages[stage] = static_cast<double>(timestamps[stage + 1] - timestamps[stage]) / 1e6;
+            this->accumulated.stages[stage] += this->latest.stages[stage];
+        }
+        this->latest.total = static_cast<double>(timestamps[timestampCount - 1] - timestamps[0]) / 1e6;
+        this->accumulated.total += this->latest.total;
+        this->accumulatedFrames++;
+
+        this->latestFrameNumber = this->frameNumbers[slot];
+        this->hasResult = true;
+        newResult = true;
+    }
+
+    if (this->logInterval != 0 && this->accumulatedFrames >= this->logInterval) {
+        this->log();
+    }
+    return newResult;
+}
+
+void GpuTimer::beginFrame() {
+    const size_t slot = this->frameNumber % frameLatency;
+    if (this->pending[slot]) {
+        // The GPU is more than frameLatency frames behind, we drop this result instead of waiting on it
+        this->pending[slot] = false;
+        this->droppedFrames++;
+    }
+
+    this->frameNumbers[slot] = this->frameNumber;
+    glQueryCounter(this->queries[slot][0], GL_TIMESTAMP);
+}
+
+void GpuTimer::endStage(const FrameStage stage) {
+    const size_t slot = this->frameNumber % frameLatency;
+    const size_t index = static_cast<size_t>(stage) + 1;
+    glQueryCounter(this->queries[slot][index], GL_TIMESTAMP);
+
+    if (index == timestampCount - 1) {
+        this->pending[slot] = true;
+        this->frameNumber++;
+    }
+}
+
+void GpuTimer::log() {
+    const auto frames = static_cast<double>(this->accumulatedFrames);
+    SDL_Log(
+        "GPU time (avg of %llu frames): upload %.3f ms, clear %.3f ms, draw %.3f ms, swap %.3f ms, frame %.3f ms, %llu dropped",
+        (unsigned long long) this->accumulatedFrames,
+        this->accumulated.stages[static_cast<size_t>(FrameStage::Upload)] / frames,
+        this->accumulated.stages[static_cast<size_t>(FrameStage::Clear)] / frames,
+        this->accumulated.stages[static_cast<size_t>(FrameStage::Draw)] / frames,
+        this->accumulated.stages[static_cast<size_t>(FrameStage::Swap)] / frames,
+        this->accumulated.total / frames,
+        (unsigned long long) this->droppedFrames
+    );
+    this->accumulated = {};
+    this->accumulatedFrames = 0;
+}
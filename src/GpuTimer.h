@@ -0,0 +1,59 @@
+#pragma once
+
+#ifndef OPENGL_TEST_GPUTIMER_H
+#define OPENGL_TEST_GPUTIMER_H
+
+#include <array>
+#include <cstdint>
+
+#include "Benchmark.h"
+
+/**
+ * Measures how long the GPU spends on each stage of a frame with GL_TIMESTAMP queries (core since OpenGL 3.3).
+ * Queries go into a ring of several frames and are only read back once the driver reports them available,
+ * so collecting the results never stalls the pipeline. Frames whose results are still not available when
+ * their slot comes around again are dropped rather than waited on.
+ */
+class GpuTimer {
+public:
+    // How many frames the GPU may lag behind before we drop a result
+    static constexpr size_t frameLatency = 4;
+    // One timestamp at the start of the frame, then one at the end of each stage
+    static constexpr size_t timestampCount = frameStageCount + 1;
+
+    std::array<std::array<unsigned int, timestampCount>, frameLatency> queries{};
+    std::array<bool, frameLatency> pending{};
+    std::array<uint64_t, frameLatency> frameNumbers{};
+    uint64_t frameNumber{};
+    bool initialized = false;
+
+    // Results of the most recent frame the GPU finished
+    FrameTimings latest;
+    uint64_t latestFrameNumber{};
+    bool hasResult = false;
+    uint64_t droppedFrames{};
+
+    // Log the average GPU timings every logInterval frames, 0 disables logging
+    uint64_t logInterval = 600;
+    FrameTimings accumulated;
+    uint64_t accumulatedFrames{};
+
+    void init();
+
+    void destroy();
+
+    // Reads back finished frames and records the start of a new frame
+    void beginFrame();
+
+    // Records the end of a stage, must be called in stage order after beginFrame
+    void endStage(FrameStage stage);
+
+    // Returns true when a new result became available since the last call
+    bool collect();
+
+private:
+    void log();
+};
+
+
+#endif //OPENGL_TEST_GPUTIMER_H
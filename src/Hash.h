@@ -0,0 +1,31 @@
+#pragma once
+
+#ifndef OPENGL_TEST_HASH_H
+#define OPENGL_TEST_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+constexpr uint64_t fnv1aOffsetBasis = 0xcbf29ce484222325ull;
+constexpr uint64_t fnv1aPrime = 0x100000001b3ull;
+
+/**
+ * 64-bit FNV-1a, cheap and good enough for lookup tables and cache keys (not for anything adversarial).
+ * Pass the previous result as seed to hash several pieces of data as one.
+ */
+constexpr uint64_t hashBytes(const unsigned char *data, const size_t size, uint64_t seed = fnv1aOffsetBasis) {
+    for (size_t i = 0; i < size; i++) {
+        seed = (seed ^ data[i]) * fnv1aPrime;
+    }
+    return seed;
+}
+
+constexpr uint64_t hashString(const std::string_view text, uint64_t seed = fnv1aOffsetBasis) {
+    for (const char c: text) {
+        seed = (seed ^ static_cast<unsigned char>(c)) * fnv1aPrime;
+    }
+    return seed;
+}
+
+#endif //OPENGL_TEST_HASH_H
@@ -0,0 +1,150 @@
+#include "HeadlessContext.h"
+
+#include <cstring>
+
+#ifdef OPENGL_TEST_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include "helperFunctions.h"
+
+#ifdef OPENGL_TEST_HAS_EGL
+
+static bool hasExtension(const char *extensions, const char *name) {
+    if (not extensions) {
+        return false;
+    }
+
+    const size_t length = strlen(name);
+    for (const char *start = extensions; (start = strstr(start, name)); start += length) {
+        // Make sure we matched a whole word and not the prefix of another extension
+        if ((start == extensions || start[-1] == ' ') && (start[length] == ' ' || start[length] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static SDL_AppResult EGL_Fail(const char *what) {
+    SDL_LogError(SDL_LOG_CATEGORY_CUSTOM, "Headless context error: %s failed (EGL error 0x%x)", what, eglGetError());
+    return SDL_APP_FAILURE;
+}
+
+SDL_AppResult HeadlessContext::init() {
+    SDL_Log("Headless context initializing");
+
+    // Prefer Mesa's surfaceless platform: it needs neither a display server nor a GPU
+    EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+    const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        const auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT")
+        );
+        if (getPlatformDisplay) {
+            eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+    }
+    if (eglDisplay == EGL_NO_DISPLAY) {
+        eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (eglDisplay == EGL_NO_DISPLAY) {
+        return EGL_Fail("eglGetDisplay");
+    }
+
+    EGLint major, minor;
+    if (not eglInitialize(eglDisplay, &major, &minor)) {
+        return EGL_Fail("eglInitialize");
+    }
+    this->display = eglDisplay;
+    SDL_Log("EGL version: %i.%i (%s)", major, minor, eglQueryString(eglDisplay, EGL_VENDOR));
+
+    if (not hasExtension(eglQueryString(eglDisplay, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context")) {
+        SDL_LogError(SDL_LOG_CATEGORY_CUSTOM, "Headless context error: EGL_KHR_surfaceless_context is not supported");
+        return SDL_APP_FAILURE;
+    }
+
+    if (not eglBindAPI(EGL_OPENGL_API)) {
+        return EGL_Fail("eglBindAPI");
+    }
+
+    // We never create a surface, but EGL_SURFACE_TYPE defaults to EGL_WINDOW_BIT which surfaceless lacks
+    constexpr EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (not eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount) || configCount == 0) {
+        return EGL_Fail("eglChooseConfig");
+    }
+
+    // Same context version as RenderEngine::setAttributes asks SDL for
+    constexpr EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE, EGL_TRUE,
+        EGL_NONE
+    };
+    this->context = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+    if (this->context == EGL_NO_CONTEXT) {
+        return EGL_Fail("eglCreateContext");
+    }
+
+    if (not this->makeCurrent()) {
+        return EGL_Fail("eglMakeCurrent");
+    }
+
+    SDL_Log("Headless context successfully initialized");
+    return SDL_APP_CONTINUE;
+}
+
+bool HeadlessContext::makeCurrent() const {
+    return eglMakeCurrent(this->display, EGL_NO_SURFACE, EGL_NO_SURFACE, this->context);
+}
+
+bool HeadlessContext::releaseCurrent() const {
+    return eglMakeCurrent(this->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+void HeadlessContext::destroy() {
+    if (this->display) {
+        this->releaseCurrent();
+        if (this->context) {
+            eglDestroyContext(this->display, this->context);
+        }
+        eglTerminate(this->display);
+    }
+    this->display = nullptr;
+    this->context = nullptr;
+}
+
+SDL_FunctionPointer HeadlessContext::getProcAddress(const char *name) {
+    return eglGetProcAddress(name);
+}
+
+#else
+
+SDL_AppResult HeadlessContext::init() {
+    SDL_LogError(SDL_LOG_CATEGORY_CUSTOM, "Headless context error: this build has no EGL support");
+    return SDL_APP_FAILURE;
+}
+
+bool HeadlessContext::makeCurrent() const {
+    return false;
+}
+
+bool HeadlessContext::releaseCurrent() const {
+    return false;
+}
+
+void HeadlessContext::destroy() {
+}
+
+SDL_FunctionPointer HeadlessContext::getProcAddress([[maybe_unused]] const char *name) {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#ifndef OPENGL_TEST_HEADLESSCONTEXT_H
+#define OPENGL_TEST_HEADLESSCONTEXT_H
+
+#include "SDL3/SDL.h"
+
+/**
+ * OpenGL 3.3 core context created through EGL without any window or surface.
+ * It lets the renderer run on machines without a display server (CI, benchmark boxes),
+ * using whatever EGL driver is installed (a GPU driver or Mesa's llvmpipe).
+ */
+class HeadlessContext {
+public:
+    // Kept as opaque pointers so that the EGL headers don't leak into the rest of the project
+    void *display{};
+    void *context{};
+
+    SDL_AppResult init();
+
+    bool makeCurrent() const;
+
+    bool releaseCurrent() const;
+
+    void destroy();
+
+    static SDL_FunctionPointer getProcAddress(const char *name);
+};
+
+
+#endif //OPENGL_TEST_HEADLESSCONTEXT_H
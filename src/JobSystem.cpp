@@ -0,0 +1,219 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+#include "SDL3/SDL.h"
+
+using namespace std;
+
+// Index of the queue owned by the current thread, the shared queue on threads that aren't workers
+static thread_local size_t currentQueue = SIZE_MAX;
+
+// Failed steals before a waiter goes to sleep, the last jobs of a group are often about to finish
+constexpr int spinsBeforeSleeping = 64;
+
+void JobSystem::init(size_t threadCount) {
+    if (threadCount == 0) {
+        // The main and render threads also run jobs while they wait
+        threadCount = max(SDL_GetNumLogicalCPUCores() - 1, 1);
+    }
+
+    this->stopping = false;
+    for (size_t i = 0; i <= threadCount; i++) {
+        this->queues.push_back(make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        this->workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+    SDL_Log("Job system: %zu worker threads", threadCount);
+}
+
+void JobSystem::shutdown() {
+    {
+        lock_guard lock(this->sleepMutex);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    this->counterDone.notify_all();
+
+    for (auto &worker: this->workers) {
+        worker.join();
+    }
+    this->workers.clear();
+    this->queues.clear();
+    this->queued = 0;
+}
+
+void JobSystem::push(Job job) {
+    if (this->queues.empty()) {
+        this->execute(job);
+        return;
+    }
+
+    const size_t index = currentQueue < this->workers.size() ? currentQueue : this->workers.size();
+    {
+        auto &queue = *this->queues[index];
+        lock_guard lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+
+    bool waiters = false;
+    {
+        // Taking the lock makes sure a worker about to sleep sees the new job
+        lock_guard lock(this->sleepMutex);
+        this->queued++;
+        waiters = this->blockedWaiters > 0;
+    }
+    this->wake.notify_one();
+    if (waiters) {
+        this->counterDone.notify_all();
+    }
+}
+
+void JobSystem::run(function<void()> function, JobCounter *counter, JobCounter *dependency) {
+    if (counter) {
+        counter->pending.fetch_add(1, memory_order_relaxed);
+    }
+
+    Job job{std::move(function), counter};
+    if (dependency) {
+        lock_guard lock(dependency->mutex);
+        if (not dependency->done()) {
+            dependency->dependents.push_back(std::move(job));
+            return;
+        }
+    }
+    this->push(std::move(job));
+}
+
+void JobSystem::execute(Job &job) {
+    job.function();
+
+    JobCounter *counter = job.counter;
+    if (not counter) {
+        return;
+    }
+
+    // Whoever brings the counter to zero schedules the jobs waiting on it. The counter may be freed as soon
+    // as the mutex is released, so nothing here touches it after that, dependents are moved out first.
+    vector<Job> dependents;
+    bool reachedZero = false;
+    {
+        lock_guard lock(counter->mutex);
+        if (counter->pending.fetch_sub(1, memory_order_acq_rel) == 1) {
+            dependents.swap(counter->dependents);
+            reachedZero = true;
+        }
+    }
+    for (auto &dependent: dependents) {
+        this->push(std::move(dependent));
+    }
+
+    if (reachedZero) {
+        bool waiters = false;
+        {
+            lock_guard lock(this->sleepMutex);
+            waiters = this->blockedWaiters > 0;
+        }
+        if (waiters) {
+            this->counterDone.notify_all();
+        }
+    }
+}
+
+bool JobSystem::tryRunOne() {
+    const size_t queueCount = this->queues.size();
+    if (queueCount == 0) {
+        return false;
+    }
+    const size_t own = min(currentQueue, queueCount - 1);
+
+    Job job;
+    bool found = false;
+
+    // Our own queue first, newest job first
+    {
+        auto &queue = *this->queues[own];
+        lock_guard lock(queue.mutex);
+        if (not queue.jobs.empty()) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+            found = true;
+        }
+    }
+
+    // Then steal the oldest job of another queue
+    for (size_t offset = 1; not found && offset < queueCount; offset++) {
+        auto &queue = *this->queues[(own + offset) % queueCount];
+        lock_guard lock(queue.mutex);
+        if (not queue.jobs.empty()) {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            found = true;
+        }
+    }
+
+    if (not found) {
+        return false;
+    }
+    this->queued--;
+    this->execute(job);
+    return true;
+}
+
+void JobSystem::workerLoop(const size_t index) {
+    currentQueue = index;
+
+    while (true) {
+        if (this->tryRunOne()) {
+            continue;
+        }
+
+        unique_lock lock(this->sleepMutex);
+        this->wake.wait(lock, [this] { return this->stopping || this->queued > 0; });
+        if (this->stopping) {
+            return;
+        }
+    }
+}
+
+void JobSystem::wait(const JobCounter &counter) {
+    int idle = 0;
+    while (not counter.done()) {
+        if (this->tryRunOne()) {
+            idle = 0;
+            continue;
+        }
+        if (++idle < spinsBeforeSleeping) {
+            this_thread::yield();
+            continue;
+        }
+
+        // Nothing to steal, the remaining jobs run elsewhere: sleep instead of burning a core
+        unique_lock lock(this->sleepMutex);
+        this->blockedWaiters++;
+        this->counterDone.wait(lock, [this, &counter] {
+            return counter.done() || this->queued > 0 || this->stopping;
+        });
+        this->blockedWaiters--;
+        idle = 0;
+    }
+
+    // The job that brought the counter to zero may still hold its mutex, the counter (often on the
+    // caller's stack) must not go away before it lets go
+    lock_guard lock(counter.mutex);
+}
+
+void JobSystem::parallelFor(const size_t count, size_t grain, const function<void(size_t begin, size_t end)> &function) {
+    if (count == 0) {
+        return;
+    }
+    grain = max<size_t>(grain, 1);
+
+    JobCounter counter;
+    for (size_t begin = 0; begin < count; begin += grain) {
+        const size_t end = min(begin + grain, count);
+        this->run([&function, begin, end] { function(begin, end); }, &counter);
+    }
+    this->wait(counter);
+}
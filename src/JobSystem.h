@@ -0,0 +1,92 @@
+#pragma once
+
+#ifndef OPENGL_TEST_JOBSYSTEM_H
+#define OPENGL_TEST_JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct JobCounter;
+
+struct Job {
+    std::function<void()> function;
+    // Decremented once the job ran
+    JobCounter *counter{};
+};
+
+/**
+ * Counts the unfinished jobs of a group. Jobs can be made to wait on a counter,
+ * they are only scheduled once it reaches zero. Must outlive the jobs it tracks.
+ */
+struct JobCounter {
+    std::atomic<int> pending = 0;
+    // Also taken by wait() before returning, see JobSystem::execute
+    mutable std::mutex mutex;
+    // Jobs waiting for this counter to reach zero
+    std::vector<Job> dependents;
+
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+/**
+ * Work-stealing job scheduler shared by the engine subsystems.
+ *
+ * Each worker owns a deque: it pushes and pops its own jobs at the back (the most recent, still
+ * hot in cache) and, once out of work, steals from the front of the other deques. Threads that
+ * aren't workers push into an extra shared deque. Waiting on a counter runs jobs in the meantime,
+ * so any thread can wait without deadlocking on nested jobs, and sleeps once there is nothing left to
+ * steal. Before init() and after shutdown() there are no queues, jobs then run inline.
+ */
+class JobSystem {
+public:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    // One queue per worker, then the shared queue for the other threads
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<bool> stopping = false;
+    std::atomic<int> queued = 0;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    // Threads sleeping in wait(), woken when a counter reaches zero or a job is queued (guarded by sleepMutex)
+    std::condition_variable counterDone;
+    int blockedWaiters = 0;
+
+    // threadCount 0 sizes the pool from the number of logical cores
+    void init(size_t threadCount = 0);
+
+    void shutdown();
+
+    size_t workerCount() const { return workers.size(); }
+
+    // Schedules function, counting it in counter if any, once dependency (if any) reached zero
+    void run(std::function<void()> function, JobCounter *counter = nullptr, JobCounter *dependency = nullptr);
+
+    // Runs other jobs until counter reaches zero
+    void wait(const JobCounter &counter);
+
+    // Calls function(begin, end) over [0, count) in chunks of at most grain items, and waits for all of them
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)> &function);
+
+private:
+    void push(Job job);
+
+    bool tryRunOne();
+
+    void execute(Job &job);
+
+    void workerLoop(size_t index);
+};
+
+
+#endif //OPENGL_TEST_JOBSYSTEM_H
@@ -0,0 +1,290 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+
+#if defined(OPENGL_TEST_SIMD_AVX2) && defined(__AVX2__)
+#define MIP_AVX2
+#endif
+#if defined(OPENGL_TEST_SIMD_SSE2) && (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64))
+#define MIP_SSE2
+#endif
+
+#if defined(MIP_AVX2)
+#include <immintrin.h>
+#elif defined(MIP_SSE2)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+// Lobes of the Kaiser windowed sinc on each side, in destination texels
+constexpr double kaiserRadius = 3.0;
+constexpr double kaiserAlpha = 4.0;
+
+// Source texels per job, enough to be worth a job without starving the other workers
+constexpr size_t texelsPerJob = 16 * 1024;
+
+const char *mipFilterName(const MipFilter filter) {
+    switch (filter) {
+        case MipFilter::Box: return "box";
+        case MipFilter::Kaiser: return "kaiser";
+    }
+    return "unknown";
+}
+
+const char *MipGenerator::instructionSet() {
+#if defined(MIP_AVX2)
+    return "AVX2";
+#elif defined(MIP_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+// An RGBA image in float, linear light when filtering in sRGB
+struct FloatImage {
+    int width{};
+    int height{};
+    vector<float> texels;
+};
+
+// The source texels a destination texel reads along one axis, always inside the image
+struct Footprint {
+    int first{};
+    vector<float> weights;
+};
+
+static double sinc(const double x) {
+    if (abs(x) < 1e-9) {
+        return 1.0;
+    }
+    return sin(numbers::pi * x) / (numbers::pi * x);
+}
+
+// Modified Bessel function of the first kind, order 0, its series converges fast for our alpha
+static double besselI0(const double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+static double kaiser(const double t) {
+    if (abs(t) >= 1.0) {
+        return 0.0;
+    }
+    return besselI0(kaiserAlpha * sqrt(1.0 - t * t)) / besselI0(kaiserAlpha);
+}
+
+static vector<Footprint> boxFootprints(const int sourceSize, const int size) {
+    const double scale = static_cast<double>(sourceSize) / size;
+    vector<Footprint> result(size);
+    for (int i = 0; i < size; i++) {
+        const double start = i * scale;
+        const double end = (i + 1) * scale;
+        auto &footprint = result[i];
+        footprint.first = static_cast<int>(start);
+        for (int source = footprint.first; source < sourceSize && source < end; source++) {
+            const double covered = min<double>(end, source + 1) - max<double>(start, source);
+            footprint.weights.push_back(static_cast<float>(covered / scale));
+        }
+    }
+    return result;
+}
+
+static vector<Footprint> kaiserFootprints(const int sourceSize, const int size) {
+    const double scale = static_cast<double>(sourceSize) / size;
+    const double support = kaiserRadius * scale;
+    vector<Footprint> result(size);
+    for (int i = 0; i < size; i++) {
+        const double center = (i + 0.5) * scale;
+        const int low = static_cast<int>(floor(center - support));
+        const int high = static_cast<int>(ceil(center + support));
+
+        // Texels past the edges repeat the edge texel, so their weight goes to it
+        auto &footprint = result[i];
+        footprint.first = max(low, 0);
+        footprint.weights.assign(min(high, sourceSize - 1) - footprint.first + 1, 0.0f);
+        double total = 0.0;
+        for (int source = low; source <= high; source++) {
+            const double x = (source + 0.5 - center) / scale;
+            const double weight = sinc(x) * kaiser(x / kaiserRadius);
+            footprint.weights[clamp(source, 0, sourceSize - 1) - footprint.first] += static_cast<float>(weight);
+            total += weight;
+        }
+        for (auto &weight: footprint.weights) {
+            weight = static_cast<float>(weight / total);
+        }
+    }
+    return result;
+}
+
+static const array<float, 256> &srgbToLinear() {
+    static const array<float, 256> table = [] {
+        array<float, 256> result{};
+        for (int i = 0; i < 256; i++) {
+            const double value = i / 255.0;
+            result[i] = static_cast<float>(value <= 0.04045 ? value / 12.92 : pow((value + 0.055) / 1.055, 2.4));
+        }
+        return result;
+    }();
+    return table;
+}
+
+// Linear to sRGB bytes, indexed by the linear value in 1/4096 steps (less than a byte of error)
+constexpr int linearSteps = 4096;
+
+static const array<unsigned char, linearSteps + 1> &linearToSrgb() {
+    static const array<unsigned char, linearSteps + 1> table = [] {
+        array<unsigned char, linearSteps + 1> result{};
+        for (int i = 0; i <= linearSteps; i++) {
+            const double value = static_cast<double>(i) / linearSteps;
+            const double encoded = value <= 0.0031308 ? value * 12.92 : 1.055 * pow(value, 1.0 / 2.4) - 0.055;
+            result[i] = static_cast<unsigned char>(lround(encoded * 255.0));
+        }
+        return result;
+    }();
+    return table;
+}
+
+// Runs body over [0, count) rows, on the workers when there are any and the rows are worth it
+static void forRows(JobSystem *jobs, const size_t count, const size_t rowTexels, const function<void(size_t, size_t)> &body) {
+    const size_t grain = max<size_t>(texelsPerJob / max<size_t>(rowTexels, 1), 1);
+    if (jobs && count > grain) {
+        jobs->parallelFor(count, grain, body);
+    } else {
+        body(0, count);
+    }
+}
+
+// out = sum of weights[k] * rows[k], over count floats
+static void weightedRowSum(float *out, const float *const *rows, const float *weights, const size_t taps, const size_t count) {
+    size_t i = 0;
+#if defined(MIP_AVX2)
+    for (; i + 8 <= count; i += 8) {
+        __m256 sum = _mm256_setzero_ps();
+        for (size_t k = 0; k < taps; k++) {
+            sum = _mm256_fmadd_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(rows[k] + i), sum);
+        }
+        _mm256_storeu_ps(out + i, sum);
+    }
+#endif
+#if defined(MIP_AVX2) || defined(MIP_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128 sum = _mm_setzero_ps();
+        for (size_t k = 0; k < taps; k++) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(rows[k] + i)));
+        }
+        _mm_storeu_ps(out + i, sum);
+    }
+#endif
+    for (; i < count; i++) {
+        float sum = 0.0f;
+        for (size_t k = 0; k < taps; k++) {
+            sum += weights[k] * rows[k][i];
+        }
+        out[i] = sum;
+    }
+}
+
+// One RGBA texel is 4 floats, so a texel is exactly one SSE register
+static void resampleRow(float *out, const float *row, const vector<Footprint> &columns) {
+    for (size_t x = 0; x < columns.size(); x++) {
+        const auto &footprint = columns[x];
+        const float *source = row + static_cast<size_t>(footprint.first) * 4;
+#if defined(MIP_AVX2) || defined(MIP_SSE2)
+        __m128 sum = _mm_setzero_ps();
+        for (size_t k = 0; k < footprint.weights.size(); k++) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(footprint.weights[k]), _mm_loadu_ps(source + k * 4)));
+        }
+        _mm_storeu_ps(out + x * 4, sum);
+#else
+        float sum[4]{};
+        for (size_t k = 0; k < footprint.weights.size(); k++) {
+            for (int c = 0; c < 4; c++) {
+                sum[c] += footprint.weights[k] * source[k * 4 + c];
+            }
+        }
+        copy_n(sum, 4, out + x * 4);
+#endif
+    }
+}
+
+static FloatImage downsample(const FloatImage &source, const MipFilter filter, JobSystem *jobs) {
+    FloatImage result{max(source.width / 2, 1), max(source.height / 2, 1), {}};
+    const auto footprints = filter == MipFilter::Kaiser ? kaiserFootprints : boxFootprints;
+    const auto columns = footprints(source.width, result.width);
+    const auto rows = footprints(source.height, result.height);
+
+    // Horizontal pass over every source row, then vertical pass over the narrower rows
+    const size_t rowFloats = static_cast<size_t>(result.width) * 4;
+    vector<float> horizontal(rowFloats * source.height);
+    forRows(jobs, source.height, source.width, [&](const size_t begin, const size_t end) {
+        for (size_t y = begin; y < end; y++) {
+            resampleRow(&horizontal[y * rowFloats], &source.texels[y * source.width * 4], columns);
+        }
+    });
+
+    result.texels.resize(rowFloats * result.height);
+    forRows(jobs, result.height, result.width, [&](const size_t begin, const size_t end) {
+        vector<const float *> taps;
+        for (size_t y = begin; y < end; y++) {
+            const auto &footprint = rows[y];
+            taps.clear();
+            for (size_t k = 0; k < footprint.weights.size(); k++) {
+                taps.push_back(&horizontal[(footprint.first + k) * rowFloats]);
+            }
+            weightedRowSum(&result.texels[y * rowFloats], taps.data(), footprint.weights.data(), taps.size(), rowFloats);
+        }
+    });
+    return result;
+}
+
+void MipGenerator::generate(const unsigned char *pixels, const int width, const int height,
+                            vector<unsigned char> &chain, vector<TextureLevel> &levels) const {
+    levels.clear();
+    size_t total = 0;
+    for (int levelWidth = width, levelHeight = height;; levelWidth = max(levelWidth / 2, 1), levelHeight = max(levelHeight / 2, 1)) {
+        const size_t size = static_cast<size_t>(levelWidth) * levelHeight * 4;
+        levels.push_back({levelWidth, levelHeight, total, size});
+        total += size;
+        if (levelWidth == 1 && levelHeight == 1) {
+            break;
+        }
+    }
+    chain.resize(total);
+    copy_n(pixels, levels[0].size, chain.data());
+
+    const auto &toLinear = srgbToLinear();
+    const auto &toSrgb = linearToSrgb();
+
+    FloatImage level{width, height, vector<float>(levels[0].size)};
+    forRows(this->jobs, height, width, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin * width * 4; i < end * width * 4; i++) {
+            const bool color = i % 4 != 3;
+            level.texels[i] = this->srgb && color ? toLinear[pixels[i]] : pixels[i] / 255.0f;
+        }
+    });
+
+    for (size_t index = 1; index < levels.size(); index++) {
+        level = downsample(level, this->filter, this->jobs);
+
+        // Kaiser overshoots near edges, so values are clamped before quantizing
+        unsigned char *out = chain.data() + levels[index].offset;
+        forRows(this->jobs, level.height, level.width, [&](const size_t begin, const size_t end) {
+            for (size_t i = begin * level.width * 4; i < end * level.width * 4; i++) {
+                const float value = clamp(level.texels[i], 0.0f, 1.0f);
+                const bool color = i % 4 != 3;
+                out[i] = this->srgb && color
+                             ? toSrgb[static_cast<size_t>(value * linearSteps + 0.5f)]
+                             : static_cast<unsigned char>(value * 255.0f + 0.5f);
+            }
+        });
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#ifndef OPENGL_TEST_MIPGENERATOR_H
+#define OPENGL_TEST_MIPGENERATOR_H
+
+#include <vector>
+
+#include "JobSystem.h"
+#include "TextureFile.h"
+
+enum class MipFilter {
+    // Average of the area each texel covers, cheap and never rings
+    Box,
+    // Kaiser windowed sinc, sharper mipmaps at the cost of a wider footprint
+    Kaiser,
+};
+
+/**
+ * Builds mip chains on the CPU, instead of leaving it to glGenerateMipmap. The result is the same on
+ * every driver, and the work happens on worker threads, next to decoding, so the GL thread only uploads.
+ *
+ * Levels are resampled separably in float from the previous level, over the exact footprint of each
+ * texel, so non power of two and odd sizes (5 -> 2) are filtered correctly. With srgb, color channels are
+ * filtered in linear light and encoded back, alpha is always linear.
+ *
+ * The inner loops use AVX2 or SSE2 depending on OPENGL_TEST_SIMD, with a scalar fallback.
+ */
+class MipGenerator {
+public:
+    MipFilter filter = MipFilter::Box;
+    bool srgb = true;
+    // Rows are spread over these when set, otherwise everything runs on the calling thread
+    JobSystem *jobs{};
+
+    /**
+     * Writes every level of an RGBA8 image, the base level included, back to back in chain.
+     * levels describes them, their offsets are relative to chain.
+     */
+    void generate(const unsigned char *pixels, int width, int height,
+                  std::vector<unsigned char> &chain, std::vector<TextureLevel> &levels) const;
+
+    static const char *instructionSet();
+};
+
+const char *mipFilterName(MipFilter filter);
+
+
+#endif //OPENGL_TEST_MIPGENERATOR_H
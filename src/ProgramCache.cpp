@@ -0,0 +1,195 @@
+#include "ProgramCache.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#include "SDL3/SDL.h"
+
+#include "glbinding/gl/gl.h"
+
+#include "glbinding-aux/ContextInfo.h"
+
+#include "Hash.h"
+
+using namespace std;
+using namespace gl;
+using namespace glbinding;
+
+// Bump whenever the file layout changes
+constexpr uint32_t cacheMagic = 0x50434742; // "BGCP"
+constexpr uint32_t cacheVersion = 1;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t size;
+    uint64_t contentHash;
+};
+
+void ProgramCache::init() {
+    this->enabled = false;
+
+    const bool supported = aux::ContextInfo::version() >= Version(4, 1)
+                           || aux::ContextInfo::extensions().contains(GLextension::GL_ARB_get_program_binary);
+    if (not supported) {
+        SDL_Log("Shader cache: program binaries are not supported, cache disabled");
+        return;
+    }
+
+    int formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount <= 0) {
+        // Some drivers expose the extension without supporting any format
+        SDL_Log("Shader cache: the driver has no program binary format, cache disabled");
+        return;
+    }
+    this->binaryFormats.resize(formatCount);
+    glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, this->binaryFormats.data());
+
+    char *prefPath = SDL_GetPrefPath("AuraCat", "opengl-test");
+    if (not prefPath) {
+        SDL_Log("Shader cache: no writable directory (%s), cache disabled", SDL_GetError());
+        return;
+    }
+    this->directory = string(prefPath) + "shader-cache/";
+    SDL_free(prefPath);
+
+    error_code error;
+    filesystem::create_directories(this->directory, error);
+    if (error) {
+        SDL_Log("Shader cache: could not create %s (%s), cache disabled", this->directory.c_str(), error.message().c_str());
+        return;
+    }
+
+    this->driverHash = hashString(aux::ContextInfo::vendor());
+    this->driverHash = hashString(aux::ContextInfo::renderer(), this->driverHash);
+    this->driverHash = hashString(aux::ContextInfo::version().toString(), this->driverHash);
+
+    this->enabled = true;
+    SDL_Log("Shader cache: using %s", this->directory.c_str());
+}
+
+uint64_t ProgramCache::key(const string_view vertexSource, const string_view fragmentSource) const {
+    uint64_t hash = hashString(vertexSource, this->driverHash);
+    // Separate the two sources so that moving text from one to the other changes the key
+    hash = hashString("\n--fragment--\n", hash);
+    return hashString(fragmentSource, hash);
+}
+
+string ProgramCache::pathOf(const uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016" PRIx64 ".bin", key);
+    return this->directory + name;
+}
+
+void ProgramCache::prepare(const unsigned int program) const {
+    if (this->enabled) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, 1);
+    }
+}
+
+bool ProgramCache::load(const uint64_t key, const unsigned int program) const {
+    if (not this->enabled) {
+        return false;
+    }
+
+    const string path = this->pathOf(key);
+    ifstream file(path, ios::binary);
+    if (not file) {
+        return false;
+    }
+
+    error_code error;
+    const uintmax_t fileSize = filesystem::file_size(path, error);
+
+    CacheHeader header{};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    // The header is checked before allocating, a corrupt size must not ask for gigabytes
+    const bool headerValid = file && not error
+                             && header.magic == cacheMagic
+                             && header.version == cacheVersion
+                             && header.size <= fileSize - sizeof(header);
+    vector<char> binary;
+    if (headerValid) {
+        binary.resize(header.size);
+        file.read(binary.data(), static_cast<streamsize>(header.size));
+    }
+    const bool complete = headerValid && file;
+    file.close();
+
+    const bool valid = complete
+                       && header.key == key
+                       && ranges::find(this->binaryFormats, static_cast<int>(header.format)) != this->binaryFormats.end()
+                       && hashBytes(reinterpret_cast<const unsigned char *>(binary.data()), binary.size()) == header.contentHash;
+    if (not valid) {
+        SDL_Log("Shader cache: discarding invalid entry %s", path.c_str());
+        filesystem::remove(path, error);
+        return false;
+    }
+
+    glProgramBinary(program, static_cast<GLenum>(header.format), binary.data(), static_cast<GLsizei>(binary.size()));
+
+    int success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (not success) {
+        // The driver may still refuse a binary it produced, e.g. after an update that kept its version string
+        SDL_Log("Shader cache: the driver rejected %s, recompiling", path.c_str());
+        filesystem::remove(path, error);
+        return false;
+    }
+
+    SDL_Log("Shader cache: loaded %s", path.c_str());
+    return true;
+}
+
+void ProgramCache::store(const uint64_t key, const unsigned int program) const {
+    if (not this->enabled) {
+        return;
+    }
+
+    int length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    vector<char> binary(length);
+    GLenum format{};
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    binary.resize(written);
+
+    const CacheHeader header{
+        .magic = cacheMagic,
+        .version = cacheVersion,
+        .key = key,
+        .format = static_cast<uint32_t>(format),
+        .size = static_cast<uint32_t>(binary.size()),
+        .contentHash = hashBytes(reinterpret_cast<const unsigned char *>(binary.data()), binary.size()),
+    };
+
+    // Write to a temporary file first so that a crash never leaves a truncated entry behind
+    const string path = this->pathOf(key);
+    const string temporaryPath = path + ".tmp";
+    {
+        ofstream file(temporaryPath, ios::binary | ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(binary.data(), static_cast<streamsize>(binary.size()));
+        if (not file) {
+            SDL_Log("Shader cache: could not write %s", temporaryPath.c_str());
+            return;
+        }
+    }
+
+    error_code error;
+    filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        SDL_Log("Shader cache: could not write %s (%s)", path.c_str(), error.message().c_str());
+        filesystem::remove(temporaryPath, error);
+    }
+}
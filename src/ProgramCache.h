@@ -0,0 +1,44 @@
+#pragma once
+
+#ifndef OPENGL_TEST_PROGRAMCACHE_H
+#define OPENGL_TEST_PROGRAMCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * On-disk cache of linked program binaries (glGetProgramBinary), so that a program whose sources
+ * didn't change since the last launch is loaded without compiling anything.
+ *
+ * Entries are keyed by a hash of the shader sources and of the driver vendor/renderer/version strings,
+ * since binaries are only valid for the exact driver that produced them. The binary format is stored
+ * next to the blob and checked against the formats the driver accepts before loading.
+ */
+class ProgramCache {
+public:
+    bool enabled = false;
+    std::string directory;
+    uint64_t driverHash{};
+    std::vector<int> binaryFormats;
+
+    // Needs a current context: checks program binary support and picks the cache directory
+    void init();
+
+    uint64_t key(std::string_view vertexSource, std::string_view fragmentSource) const;
+
+    // Must be called before linking a program that is going to be stored
+    void prepare(unsigned int program) const;
+
+    // Loads the cached binary into program, returns false on a miss or if the driver rejected the binary
+    bool load(uint64_t key, unsigned int program) const;
+
+    void store(uint64_t key, unsigned int program) const;
+
+private:
+    std::string pathOf(uint64_t key) const;
+};
+
+
+#endif //OPENGL_TEST_PROGRAMCACHE_H
@@ -1,5 +1,6 @@
 #include "RenderEngine.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include "glbinding/glbinding.h"
@@ -11,9 +12,7 @@
 #include "glbinding-aux/ValidVersions.h"
 #include "glbinding-aux/debug.h"
 
-#include "../vendored/stb_image.h"
-
-#include "AppContext.h"
+#include "Assets.h"
 #include "helperFunctions.h"
 
 using namespace std;
@@ -28,15 +27,24 @@ float vertices[] = {
    -0.5f,  0.5f, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f    // top left
 };
 
+// Starting size of each stream buffer region, it grows when a frame needs more
+constexpr size_t streamRegionSize = 1 << 20;
+
+// Packed into spriteAtlas, the sprites pick their image from its regions in the same order
+constexpr const char *spriteImages[] = {"./textures/container.jpg"};
+
 unsigned int indices[] = {  // note that we start from 0!
     0, 1, 3,   // first triangle
     1, 2, 3    // second triangle
 };
 
-void RenderEngine::viewport_resize() const {
-    int width, height;
-    SDL_GetWindowSizeInPixels(window, &width, &height);
-    glViewport(0, 0, width, height);
+void RenderEngine::viewport_resize(const int width, const int height) {
+    if (this->backend == RenderBackend::Headless) {
+        this->state.setViewport(0, 0, framebufferWidth, framebufferHeight);
+        return;
+    }
+
+    this->state.setViewport(0, 0, width, height);
 }
 
 SDL_AppResult RenderEngine::setAttributes() {
@@ -72,27 +80,69 @@ SDL_Window *RenderEngine::createWindow(
     return window;
 }
 
+/**
+ * Creates the offscreen framebuffer the headless backend renders into,
+ * and leaves it bound so that every draw call targets it.
+ *
+ * @param w width in pixels
+ * @param h height in pixels
+ */
+SDL_AppResult RenderEngine::createFramebuffer(const int w, const int h) {
+    this->framebufferWidth = w;
+    this->framebufferHeight = h;
+
+    glGenRenderbuffers(1, &this->colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+
+    glGenFramebuffers(1, &this->framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->colorBuffer);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        SDL_LogError(0, "Render engine error: Offscreen framebuffer is incomplete");
+        return SDL_APP_FAILURE;
+    }
+
+    SDL_Log("OpenGL: Rendering offscreen to a %ix%i framebuffer", w, h);
+    return SDL_APP_CONTINUE;
+}
+
 SDL_AppResult RenderEngine::init() {
     SDL_Log("OpenGL renderer initializing");
 
-    if (SDL_GLContext context = SDL_GL_CreateContext(this->window); not context) {
-        return SDL_Fail();
-    }
+    if (this->backend == RenderBackend::Headless) {
+        if (this->headless.init() == SDL_APP_FAILURE) {
+            return SDL_APP_FAILURE;
+        }
+
+        // Load OpenGL functions
+        initialize(HeadlessContext::getProcAddress);
+    } else {
+        this->context = SDL_GL_CreateContext(this->window);
+        if (not this->context) {
+            return SDL_Fail();
+        }
 
-    // Load OpenGL functions
-    initialize(SDL_GL_GetProcAddress);
+        // Load OpenGL functions
+        initialize(SDL_GL_GetProcAddress);
+    }
     aux::enableGetErrorCallback();
 
     SDL_Log("OpenGL version: %s", aux::ContextInfo::version().toString().c_str());
     SDL_Log("OpenGL vendor: %s", aux::ContextInfo::vendor().c_str());
     SDL_Log("OpenGL renderer: %s", aux::ContextInfo::renderer().c_str());
 
-    if (not SDL_GL_SetSwapInterval(1)) {
-        return SDL_Fail();
+    if (this->backend == RenderBackend::Headless) {
+        if (this->createFramebuffer(this->framebufferWidth, this->framebufferHeight) == SDL_APP_FAILURE) {
+            return SDL_APP_FAILURE;
+        }
+    } else {
+        if (not SDL_GL_SetSwapInterval(this->vsync ? 1 : 0)) {
+            return SDL_Fail();
+        }
+        SDL_Log("OpenGL: VSync %s", this->vsync ? "activated" : "deactivated");
     }
-    SDL_Log("OpenGL: VSync activated");
-
-    this->viewport_resize();
 
     // Color used when clearing the framebuffer
     glClearColor(0.3f, 0.4f, 0.7f, 1.0f);
@@ -101,38 +151,43 @@ SDL_AppResult RenderEngine::init() {
     glGenVertexArrays(1, &VAO);
     glBindVertexArray(VAO);
 
-    unsigned int EBO;
     glGenBuffers(1, &EBO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
     // Create our vertex buffer object which will store vertices
     // TODO: Later on we could put it in a model loading function
-    unsigned int VBO;
     glGenBuffers(1, &VBO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-    stbi_set_flip_vertically_on_load(true);
-
-    int width, height, nrChannels;
-    unsigned char *data = stbi_load("./textures/container.jpg", &width, &height, &nrChannels, 0);
+    // Hot reload watches the loose files, so those must win over the embedded copies
+    Assets::preferFiles = this->watchShaders;
+    if (Assets::hasEmbedded()) {
+        SDL_Log("Loading assets embedded in the executable%s", Assets::preferFiles ? " (loose files first)" : "");
+    }
 
-    glGenTextures(1, &this->texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    // Decoded in the background, the texture shows a placeholder until then
+    this->textureLoader.init(*this->jobs);
+    this->textureLoader.load("./textures/container.jpg", &this->texture);
+    this->textureLoader.loadAtlas(this->state, this->spriteAtlas, spriteImages);
 
-    if (data) {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    } else {
-        SDL_Log("Render engine error: Failed to load texture");
-        return SDL_APP_FAILURE;
+    if (this->useProgramCache) {
+        this->programCache.init();
     }
-    stbi_image_free(data);
 
-    if (this->shader.init("./shaders/shader.vsh", "./shaders/shader.fsh") == SDL_APP_FAILURE) {
-        return SDL_APP_FAILURE;
+    // Every program is compiled at once, so that drivers with parallel compilation can use all their threads
+    Shader::enableParallelCompile();
+    this->shaders.init("./shaders/shader.vsh", "./shaders/shader.fsh", &this->programCache);
+    this->shaders.configure = [this](Shader &program) {
+        this->state.useProgram(program.ID);
+        program.setInt(program.uniform("ourTexture"), 0);
     };
+    // Instanced sprites reuse the quad geometry
+    const ShaderFeatures startupVariants[] = {this->quadFeatures, this->spriteFeatures};
+    if (this->shaders.prewarm(startupVariants) == SDL_APP_FAILURE) {
+        return SDL_APP_FAILURE;
+    }
 
     // Position attribute
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *) 0);
@@ -146,22 +201,239 @@ SDL_AppResult RenderEngine::init() {
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
 
+    // Uniform blocks are bound from the stream buffer, so its allocations must be aligned for them
+    int uniformAlignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    this->streamBuffer.init(streamRegionSize, max<size_t>(uniformAlignment, 16));
+    this->spriteBatch.init(this->VBO, this->EBO, this->streamBuffer);
+
+    if (this->watchShaders) {
+        this->shaderWatcher.start("./shaders");
+    }
+
+    this->gpuTimer.init();
+
+    // Everything above talked to GL directly
+    this->state.invalidate();
+
     SDL_Log("OpenGL renderer successfully initialized");
 
     return SDL_APP_CONTINUE;
 }
 
-SDL_AppResult RenderEngine::render(const AppContext *app) const {
-    glClear(ClearBufferMask::GL_COLOR_BUFFER_BIT);
+void RenderEngine::reloadChangedShaders() {
+    const auto changes = this->shaderWatcher.takeChanges();
 
-    glUseProgram(this->shader.ID);
+    const auto submitReload = [this](Shader *program) {
+        auto &reload = this->pendingReloads.emplace_back(PendingReload{program});
+        if (reload.rebuilt.load(program->vertexPath.c_str(), program->fragmentPath.c_str(), program->defines) == SDL_APP_CONTINUE) {
+            reload.rebuilt.submit(&this->programCache);
+        }
+    };
 
-    glBindVertexArray(this->VAO);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    // Submit a rebuild of every program using a changed file, the current program keeps drawing meanwhile
+    for (auto &[features, variant]: this->shaders.variants) {
+        Shader *program = variant.get();
+        const bool changed = ranges::any_of(changes, [program](const string &file) { return program->uses(file); });
+        if (not changed) {
+            continue;
+        }
+
+        // The rebuild in flight read the previous sources, the change is picked up once it is done
+        const auto rebuilding = ranges::find(this->pendingReloads, program, &PendingReload::target);
+        if (rebuilding != this->pendingReloads.end()) {
+            rebuilding->stale = true;
+            continue;
+        }
+        submitReload(program);
+    }
 
-    // We swap the buffers
-    if (not SDL_GL_SwapWindow(this->window)) {
-        return SDL_Fail();
+    // Swap in the rebuilt programs the driver is done with
+    vector<Shader *> resubmit;
+    for (auto it = this->pendingReloads.begin(); it != this->pendingReloads.end();) {
+        if (not it->rebuilt.isReady()) {
+            ++it;
+            continue;
+        }
+
+        Shader *target = it->target;
+        if (it->rebuilt.finish(&this->programCache) == SDL_APP_CONTINUE) {
+            target->destroy();
+            *target = std::move(it->rebuilt);
+            SDL_Log("Shader: reloaded %s / %s", target->vertexPath.c_str(), target->fragmentPath.c_str());
+            // Everything above talked to GL directly
+            this->state.invalidate();
+            this->shaders.configure(*target);
+        } else {
+            it->rebuilt.destroy();
+            SDL_LogError(0, "Shader error: Keeping the previous %s / %s program", target->vertexPath.c_str(), target->fragmentPath.c_str());
+        }
+        if (it->stale) {
+            resubmit.push_back(target);
+        }
+        it = this->pendingReloads.erase(it);
     }
+    for (Shader *program: resubmit) {
+        submitReload(program);
+    }
+}
+
+static double elapsedMilliseconds(const uint64_t start, const uint64_t end) {
+    return static_cast<double>(end - start) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+bool RenderEngine::makeCurrent() {
+    if (this->backend == RenderBackend::Headless) {
+        return this->headless.makeCurrent();
+    }
+    return SDL_GL_MakeCurrent(this->window, this->context);
+}
+
+bool RenderEngine::releaseCurrent() {
+    if (this->backend == RenderBackend::Headless) {
+        return this->headless.releaseCurrent();
+    }
+    return SDL_GL_MakeCurrent(this->window, nullptr);
+}
+
+SDL_AppResult RenderEngine::render(const FrameSnapshot &frame) {
+    const uint64_t frameStart = SDL_GetPerformanceCounter();
+
+    this->gpuTimer.collect();
+    this->gpuTimer.beginFrame();
+
+    if (this->watchShaders) {
+        this->reloadChangedShaders();
+    }
+    this->textureLoader.update(this->state);
+    this->gpuTimer.endStage(FrameStage::Upload);
+
+    const uint64_t uploadEnd = SDL_GetPerformanceCounter();
+
+    glClear(ClearBufferMask::GL_COLOR_BUFFER_BIT);
+    this->gpuTimer.endStage(FrameStage::Clear);
+
+    const uint64_t clearEnd = SDL_GetPerformanceCounter();
+
+    this->viewport_resize(frame.width, frame.height);
+    this->state.setPolygonMode(frame.wireframe ? PolygonMode::Line : PolygonMode::Fill);
+
+    auto &frameData = this->frameBlock.data;
+    frameData.deltaTime = frame.time - frameData.time;
+    frameData.time = frame.time;
+    // Taken from the viewport, which knows the headless framebuffer size
+    frameData.resolution = {static_cast<float>(this->state.viewport[2]), static_cast<float>(this->state.viewport[3])};
+    frameData.frameNumber = static_cast<uint32_t>(frame.frameNumber);
+    this->frameBlock.upload(this->state, this->streamBuffer);
+    this->viewBlock.upload(this->state, this->streamBuffer);
+
+    // A variant that failed to build draws nothing rather than stopping the renderer
+    const Shader *quadProgram = this->shaders.get(this->quadFeatures);
+    const Shader *spriteProgram = this->shaders.get(this->spriteFeatures);
+
+    this->drawQueue.clear();
+    if (quadProgram) {
+        this->drawQueue.submit({
+            .pass = RenderPass::Opaque,
+            .program = quadProgram->ID,
+            .texture = this->texture,
+            .vertexArray = this->VAO,
+            .indexCount = 6,
+        });
+    }
+    if (spriteProgram && not frame.sprites.empty()) {
+        this->drawQueue.submit({
+            .pass = RenderPass::Transparent,
+            .program = spriteProgram->ID,
+            .texture = this->spriteAtlas.texture,
+            .textureTarget = TextureTarget::Texture2DArray,
+            .vertexArray = this->spriteBatch.VAO,
+            .batch = &this->spriteBatch,
+            .instances = frame.sprites,
+        });
+    }
+    this->drawQueue.sort();
+    this->drawQueue.execute(this->state);
+    this->gpuTimer.endStage(FrameStage::Draw);
+
+    const uint64_t drawEnd = SDL_GetPerformanceCounter();
+
+    if (this->backend == RenderBackend::Headless) {
+        // Nothing to present, we just make sure the commands get submitted
+        glFlush();
+    } else {
+        // We swap the buffers
+        if (not SDL_GL_SwapWindow(this->window)) {
+            return SDL_Fail();
+        }
+    }
+    this->gpuTimer.endStage(FrameStage::Swap);
+
+    this->streamBuffer.endFrame(this->state);
+
+    const uint64_t frameEnd = SDL_GetPerformanceCounter();
+
+    this->frameTimings.stages[static_cast<size_t>(FrameStage::Upload)] = elapsedMilliseconds(frameStart, uploadEnd);
+    this->frameTimings.stages[static_cast<size_t>(FrameStage::Clear)] = elapsedMilliseconds(uploadEnd, clearEnd);
+    this->frameTimings.stages[static_cast<size_t>(FrameStage::Draw)] = elapsedMilliseconds(clearEnd, drawEnd);
+    this->frameTimings.stages[static_cast<size_t>(FrameStage::Swap)] = elapsedMilliseconds(drawEnd, frameEnd);
+    this->frameTimings.total = elapsedMilliseconds(frameStart, frameEnd);
+
     return SDL_APP_CONTINUE;
 }
+
+void RenderEngine::shutdown() {
+    SDL_Log(
+        "GL state cache: %llu calls issued, %llu redundant calls skipped",
+        (unsigned long long) this->state.stats.issued, (unsigned long long) this->state.stats.skipped
+    );
+    SDL_Log(
+        "Stream buffer: %llu stalls, grown %llu times",
+        (unsigned long long) this->streamBuffer.stalls, (unsigned long long) this->streamBuffer.grows
+    );
+
+    this->shaderWatcher.stop();
+    for (auto &reload: this->pendingReloads) {
+        reload.rebuilt.finish();
+        reload.rebuilt.destroy();
+    }
+    this->pendingReloads.clear();
+    this->shaders.destroy();
+    // Until it has loaded, the texture is the loader's placeholder, which the loader deletes itself
+    if (this->texture && this->texture != this->textureLoader.placeholder) {
+        glDeleteTextures(1, &this->texture);
+    }
+    this->texture = 0;
+    this->textureLoader.shutdown();
+    this->spriteAtlas.destroy(this->state);
+    this->spriteBatch.destroy();
+    this->streamBuffer.destroy(this->state);
+    this->gpuTimer.destroy();
+
+    // Init may have failed before creating any of them, without a context to delete them from
+    if (this->VAO) {
+        glDeleteVertexArrays(1, &this->VAO);
+        glDeleteBuffers(1, &this->VBO);
+        glDeleteBuffers(1, &this->EBO);
+        this->VAO = this->VBO = this->EBO = 0;
+    }
+    if (this->framebuffer) {
+        glDeleteFramebuffers(1, &this->framebuffer);
+        glDeleteRenderbuffers(1, &this->colorBuffer);
+        this->framebuffer = this->colorBuffer = 0;
+    }
+
+    if (this->backend == RenderBackend::Headless) {
+        this->headless.destroy();
+        return;
+    }
+
+    if (this->context) {
+        SDL_GL_DestroyContext(this->context);
+        this->context = nullptr;
+    }
+    if (this->window) {
+        SDL_DestroyWindow(this->window);
+        this->window = nullptr;
+    }
+}
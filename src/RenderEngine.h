@@ -5,20 +5,86 @@
 
 #include "SDL3/SDL.h"
 
+#include "Benchmark.h"
+#include "DrawQueue.h"
+#include "FrameSnapshot.h"
+#include "GLStateCache.h"
+#include "GpuTimer.h"
+#include "HeadlessContext.h"
+#include "ProgramCache.h"
 #include "Shader.h"
+#include "ShaderVariants.h"
+#include "ShaderWatcher.h"
+#include "SpriteBatch.h"
+#include "StreamBuffer.h"
+#include "UniformBlock.h"
+#include "TextureAtlas.h"
+#include "TextureLoader.h"
 
-struct AppContext;
+enum class RenderBackend {
+    // Renders to the back buffer of an SDL window
+    Window,
+    // Renders to an offscreen framebuffer through an EGL context, no window or display server needed
+    Headless,
+};
 
 class RenderEngine {
 public:
-    Shader shader;
+    // Every program is a variant of shaders/shader.vsh and shader.fsh
+    ShaderVariants shaders;
+    ShaderFeatures quadFeatures = SHADER_TEXTURED;
+    ShaderFeatures spriteFeatures = SHADER_TEXTURED | SHADER_INSTANCED | SHADER_TEXTURE_ARRAY;
+    SpriteBatch spriteBatch;
+    // Per frame dynamic data, written straight into GPU visible memory
+    StreamBuffer streamBuffer;
+    // Shared by every program, uploaded once per frame
+    UniformBlock<FrameBlock> frameBlock{UniformBinding::Frame};
+    UniformBlock<ViewBlock> viewBlock{UniformBinding::View};
+    DrawQueue drawQueue;
+    GLStateCache state;
+    ProgramCache programCache;
+    bool useProgramCache = true;
+    // Rebuilds the programs whose sources change on disk, with --watch-shaders
+    ShaderWatcher shaderWatcher;
+    bool watchShaders = false;
+
+    // A program being rebuilt in the background, swapped in once the driver is done with it
+    struct PendingReload {
+        Shader *target{};
+        Shader rebuilt;
+        // A source changed again after this rebuild read it, so it is rebuilt once more after the swap
+        bool stale = false;
+    };
+    std::vector<PendingReload> pendingReloads;
+    RenderBackend backend = RenderBackend::Window;
     SDL_Window *window{};
+    SDL_GLContext context{};
+    HeadlessContext headless;
+
+    // Offscreen render target used by the headless backend
+    unsigned int framebuffer{};
+    unsigned int colorBuffer{};
+    int framebufferWidth{};
+    int framebufferHeight{};
 
-    bool wireframe = false;
+    bool vsync = true;
     unsigned int VAO{};
+    unsigned int VBO{};
+    unsigned int EBO{};
     unsigned int texture{};
+    TextureLoader textureLoader;
+    // Every sprite image, packed into one texture array so that all sprites draw with a single bind
+    TextureAtlas spriteAtlas;
+    // Owned by the app, must be initialized before init()
+    JobSystem *jobs{};
 
-    void viewport_resize() const;
+    // CPU timings of the last rendered frame
+    FrameTimings frameTimings;
+    // GPU timings, available a few frames after the fact
+    GpuTimer gpuTimer;
+
+    // Takes the drawable size in pixels, the headless backend always uses its framebuffer size
+    void viewport_resize(int width, int height);
 
     static SDL_AppResult setAttributes();
 
@@ -28,9 +94,22 @@ public:
         SDL_WindowFlags flags
     );
 
+    SDL_AppResult createFramebuffer(int w, int h);
+
     SDL_AppResult init();
 
-    SDL_AppResult render(const AppContext *app) const;
+    // Makes the GL context current on the calling thread, for handing it over to the render thread
+    bool makeCurrent();
+
+    bool releaseCurrent();
+
+    SDL_AppResult render(const FrameSnapshot &frame);
+
+    void shutdown();
+
+private:
+    // Runs at the start of a frame, so a program is never swapped in the middle of one
+    void reloadChangedShaders();
 };
 
 
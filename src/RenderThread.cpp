@@ -0,0 +1,43 @@
+#include "RenderThread.h"
+
+#include "RenderEngine.h"
+#include "helperFunctions.h"
+
+using namespace std;
+
+void RenderThread::start(RenderEngine &renderer, TripleBuffer<FrameSnapshot> &mailbox, FrameCallback renderFrame) {
+    this->running = true;
+    this->result = SDL_APP_CONTINUE;
+    this->thread = std::thread([this, &renderer, &mailbox, renderFrame = std::move(renderFrame)] {
+        this->loop(renderer, mailbox, renderFrame);
+    });
+}
+
+void RenderThread::loop(RenderEngine &renderer, TripleBuffer<FrameSnapshot> &mailbox, const FrameCallback &renderFrame) {
+    if (not renderer.makeCurrent()) {
+        this->result = SDL_Fail();
+        this->running = false;
+        return;
+    }
+    SDL_Log("Render thread started");
+
+    while (this->running.load(memory_order_relaxed)) {
+        mailbox.consume();
+
+        if (const auto appResult = renderFrame(mailbox.readBuffer()); appResult != SDL_APP_CONTINUE) {
+            this->result = appResult;
+            break;
+        }
+    }
+
+    renderer.releaseCurrent();
+    this->running = false;
+    SDL_Log("Render thread stopped");
+}
+
+void RenderThread::stop() {
+    this->running = false;
+    if (this->thread.joinable()) {
+        this->thread.join();
+    }
+}
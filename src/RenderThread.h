@@ -0,0 +1,42 @@
+#pragma once
+
+#ifndef OPENGL_TEST_RENDERTHREAD_H
+#define OPENGL_TEST_RENDERTHREAD_H
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "SDL3/SDL.h"
+
+#include "FrameSnapshot.h"
+#include "TripleBuffer.h"
+
+class RenderEngine;
+
+/**
+ * Owns the GL context while running and renders the latest snapshot published by the main thread,
+ * so that event handling and simulation never wait on a buffer swap and the renderer never waits on events.
+ * When no new snapshot arrived, the previous one is rendered again.
+ */
+class RenderThread {
+public:
+    // Renders one frame, returning anything but SDL_APP_CONTINUE stops the thread
+    using FrameCallback = std::function<SDL_AppResult(const FrameSnapshot &frame)>;
+
+    std::thread thread;
+    std::atomic<bool> running = false;
+    std::atomic<SDL_AppResult> result = SDL_APP_CONTINUE;
+
+    // The context must not be current on the calling thread anymore
+    void start(RenderEngine &renderer, TripleBuffer<FrameSnapshot> &mailbox, FrameCallback renderFrame);
+
+    // Waits for the current frame to end, the context is then current on no thread
+    void stop();
+
+private:
+    void loop(RenderEngine &renderer, TripleBuffer<FrameSnapshot> &mailbox, const FrameCallback &renderFrame);
+};
+
+
+#endif //OPENGL_TEST_RENDERTHREAD_H
@@ -1,114 +1,352 @@
 #include "Shader.h"
 
-#include <fstream>
-#include <sstream>
-#include <iostream>
+#include <algorithm>
+#include <filesystem>
 
 #include "SDL3/SDL_log.h"
 
 #include "glbinding/glbinding.h"
-#include "glbinding/gl33core/gl.h"
+#include "glbinding/gl/gl.h"
+
+#include "glbinding-aux/ContextInfo.h"
+
+#include "Hash.h"
+#include "ProgramCache.h"
+#include "ShaderPreprocessor.h"
+#include "UniformBlock.h"
 
 using namespace std;
-using namespace gl33core;
+using namespace gl;
 using namespace glbinding;
 
-SDL_AppResult Shader::init(const char *vertexPath, const char *fragmentPath) {
-    // 1. Retrieve the vertex/fragment source code from file path
-
-    string vertexCode;
-    string fragmentCode;
-    ifstream vShaderFile;
-    ifstream fShaderFile;
-
-    // Ensure ifstream objects can throw exceptions
-    vShaderFile.exceptions(ifstream::failbit | ifstream::badbit);
-    fShaderFile.exceptions(ifstream::failbit | ifstream::badbit);
-
-    try {
-        // Open files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        stringstream vShaderStream, fShaderStream;
-        // Read files' buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        // Close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
-        // Convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
-    } catch (ifstream::failure &e) {
-        SDL_LogError(0, "Shader error: File not successfully read\n%i%s", e.code().value(), e.what());
+void Shader::enableParallelCompile() {
+    const auto extensions = aux::ContextInfo::extensions();
+    if (extensions.contains(GLextension::GL_KHR_parallel_shader_compile)) {
+        // 0xFFFFFFFF lets the driver pick its own number of threads
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        parallelCompile = true;
+    } else if (extensions.contains(GLextension::GL_ARB_parallel_shader_compile)) {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        parallelCompile = true;
+    }
+    SDL_Log("OpenGL: Parallel shader compilation %s", parallelCompile ? "available" : "unavailable");
+}
+
+SDL_AppResult Shader::init(
+    const char *vertexPath, const char *fragmentPath,
+    const ProgramCache *cache, const string_view defines
+) {
+    if (this->load(vertexPath, fragmentPath, defines) == SDL_APP_FAILURE) {
         return SDL_APP_FAILURE;
     }
+    this->submit(cache);
+    return this->finish(cache);
+}
 
-    const char *vShaderCode = vertexCode.c_str();
-    const char *fShaderCode = fragmentCode.c_str();
+static string_view trimLeft(const string_view text) {
+    const size_t start = text.find_first_not_of(" \t");
+    return start == string_view::npos ? string_view{} : text.substr(start);
+}
 
-    // 2. Compile shaders
+// Matches "#version", with any spacing around the '#'
+static bool isVersionDirective(const string_view line) {
+    const string_view trimmed = trimLeft(line);
+    return trimmed.starts_with('#') && trimLeft(trimmed.substr(1)).starts_with("version");
+}
 
-    unsigned int vertex, fragment;
-    int success;
-    char infoLog[512];
+/**
+ * Inserts defines right after the #version line, which must stay the first directive,
+ * then resets the line number so that compile errors still match the file
+ */
+static void injectDefines(string &source, const string_view defines) {
+    if (defines.empty()) {
+        return;
+    }
 
-    // Vertex shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, nullptr);
-    glCompileShader(vertex);
+    size_t insertAt = 0;
+    size_t nextLine = 1;
+    for (size_t start = 0, line = 1; start < source.size(); line++) {
+        const size_t end = source.find('\n', start);
+        if (isVersionDirective(string_view(source).substr(start, end - start))) {
+            if (end == string::npos) {
+                source += '\n';
+            }
+            insertAt = source.find('\n', start) + 1;
+            nextLine = line + 1;
+            break;
+        }
+        if (end == string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
 
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertex, 512, nullptr, infoLog);
-        SDL_LogError(0, "Shader error: Vertex shader compilation failed!\n%s", infoLog);
+    source.insert(insertAt, string(defines) + "#line " + to_string(nextLine) + "\n");
+}
+
+SDL_AppResult Shader::load(const char *vertexPath, const char *fragmentPath, const string_view defines) {
+    this->vertexPath = vertexPath;
+    this->fragmentPath = fragmentPath;
+    this->defines = defines;
+
+    // Includes are relative to the directory of the sources
+    const auto directory = filesystem::path(vertexPath).parent_path().string();
+    const ShaderPreprocessor preprocessor(directory.empty() ? "." : directory);
+
+    PreprocessedSource vertexSource, fragmentSource;
+    if (not preprocessor.process(this->vertexPath, vertexSource) || not preprocessor.process(this->fragmentPath, fragmentSource)) {
+        this->status = ShaderStatus::Failed;
         return SDL_APP_FAILURE;
     }
 
-    // Fragment shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, nullptr);
-    glCompileShader(fragment);
+    this->vertexCode = std::move(vertexSource.code);
+    this->fragmentCode = std::move(fragmentSource.code);
+    injectDefines(this->vertexCode, defines);
+    injectDefines(this->fragmentCode, defines);
 
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragment, 512, nullptr, infoLog);
-        SDL_LogError(0, "Shader error: Fragment shader compilation failed!\n%s", infoLog);
-        return SDL_APP_FAILURE;
+    this->vertexFiles = std::move(vertexSource.files);
+    this->fragmentFiles = std::move(fragmentSource.files);
+
+    this->status = ShaderStatus::Loaded;
+    return SDL_APP_CONTINUE;
+}
+
+void Shader::submit(const ProgramCache *cache) {
+    if (this->status != ShaderStatus::Loaded) {
+        return;
     }
+    this->status = ShaderStatus::Compiling;
+
+    // The program binary cache lets us skip compilation entirely
+    if (cache && cache->enabled) {
+        this->cacheKey = cache->key(this->vertexCode, this->fragmentCode);
+
+        this->ID = glCreateProgram();
+        if (cache->load(this->cacheKey, this->ID)) {
+            this->loadedFromCache = true;
+            return;
+        }
+        glDeleteProgram(this->ID);
+        this->ID = 0;
+    }
+
+    const char *vShaderCode = this->vertexCode.c_str();
+    const char *fShaderCode = this->fragmentCode.c_str();
+
+    // We don't query any status here: the driver may compile and link in the background until finish()
+    this->vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(this->vertexShader, 1, &vShaderCode, nullptr);
+    glCompileShader(this->vertexShader);
+
+    this->fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(this->fragmentShader, 1, &fShaderCode, nullptr);
+    glCompileShader(this->fragmentShader);
 
-    // Shader program
     this->ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
-
-    glGetProgramiv(ID, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragment, 512, nullptr, infoLog);
-        SDL_LogError(0, "Shader error: Shader program linking failed!\n%s", infoLog);
-        return SDL_APP_FAILURE;
+    glAttachShader(this->ID, this->vertexShader);
+    glAttachShader(this->ID, this->fragmentShader);
+    if (cache) {
+        cache->prepare(this->ID);
+    }
+    glLinkProgram(this->ID);
+}
+
+bool Shader::isReady() const {
+    if (not parallelCompile || this->status != ShaderStatus::Compiling) {
+        return true;
+    }
+
+    // Linking completes after both shaders compiled
+    int completed = 0;
+    glGetProgramiv(this->ID, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed != 0;
+}
+
+SDL_AppResult Shader::finish(const ProgramCache *cache) {
+    if (this->status != ShaderStatus::Compiling) {
+        return this->status == ShaderStatus::Ready ? SDL_APP_CONTINUE : SDL_APP_FAILURE;
     }
 
-    // Delete the shaders as they are no longer necessary
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    if (not this->loadedFromCache) {
+        int success;
+        char infoLog[512];
 
+        const char *failure = nullptr;
+        // Errors report the source string number set by the #line directives of the preprocessor
+        const vector<string> *failedFiles = nullptr;
+        glGetShaderiv(this->vertexShader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(this->vertexShader, 512, nullptr, infoLog);
+            failure = "Vertex shader compilation failed!";
+            failedFiles = &this->vertexFiles;
+        }
+        if (not failure) {
+            glGetShaderiv(this->fragmentShader, GL_COMPILE_STATUS, &success);
+            if (!success) {
+                glGetShaderInfoLog(this->fragmentShader, 512, nullptr, infoLog);
+                failure = "Fragment shader compilation failed!";
+                failedFiles = &this->fragmentFiles;
+            }
+        }
+        if (not failure) {
+            glGetProgramiv(this->ID, GL_LINK_STATUS, &success);
+            if (!success) {
+                glGetProgramInfoLog(this->ID, 512, nullptr, infoLog);
+                failure = "Shader program linking failed!";
+            }
+        }
+
+        // Delete the shaders as they are no longer necessary
+        glDeleteShader(this->vertexShader);
+        glDeleteShader(this->fragmentShader);
+        this->vertexShader = 0;
+        this->fragmentShader = 0;
+
+        if (failure) {
+            SDL_LogError(0, "Shader error: %s (%s / %s)\n%s", failure, this->vertexPath.c_str(), this->fragmentPath.c_str(), infoLog);
+            for (size_t i = 0; failedFiles && i < failedFiles->size(); i++) {
+                SDL_LogError(0, "  source %zu: %s", i, (*failedFiles)[i].c_str());
+            }
+            this->destroy();
+            this->status = ShaderStatus::Failed;
+            return SDL_APP_FAILURE;
+        }
+
+        if (cache) {
+            cache->store(this->cacheKey, this->ID);
+        }
+    }
+
+    // The sources are only needed until the program exists
+    this->vertexCode = {};
+    this->fragmentCode = {};
+
+    this->reflectUniforms();
+    if (not this->bindUniformBlocks()) {
+        this->destroy();
+        this->status = ShaderStatus::Failed;
+        return SDL_APP_FAILURE;
+    }
+
+    this->status = ShaderStatus::Ready;
     return SDL_APP_CONTINUE;
 }
 
+bool Shader::uses(const string_view fileName) const {
+    const auto matches = [fileName](const string &path) {
+        return path.ends_with(fileName) && (path.size() == fileName.size() || path[path.size() - fileName.size() - 1] == '/');
+    };
+    return ranges::any_of(this->vertexFiles, matches) || ranges::any_of(this->fragmentFiles, matches);
+}
+
+void Shader::destroy() {
+    if (this->ID) {
+        glDeleteProgram(this->ID);
+        this->ID = 0;
+    }
+    this->uniforms.clear();
+}
+
+void Shader::reflectUniforms() {
+    this->uniforms.clear();
+
+    int uniformCount = 0, maxNameLength = 0;
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    string name(maxNameLength, '\0');
+    for (int i = 0; i < uniformCount; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type;
+        glGetActiveUniform(this->ID, i, maxNameLength, &length, &size, &type, name.data());
+
+        const string_view uniformName(name.data(), length);
+        const int location = glGetUniformLocation(this->ID, name.c_str());
+        // Uniforms inside uniform blocks have no location
+        if (location == -1) {
+            continue;
+        }
+
+        this->uniforms.push_back({hashString(uniformName), location, string(uniformName)});
+
+        // Arrays are reported as "name[0]", but they can also be referred to as just "name"
+        if (uniformName.ends_with("[0]")) {
+            const string_view baseName = uniformName.substr(0, uniformName.size() - 3);
+            this->uniforms.push_back({hashString(baseName), location, string(baseName)});
+        }
+    }
+
+    ranges::sort(this->uniforms, {}, &UniformEntry::hash);
+}
+
+bool Shader::bindUniformBlocks() const {
+    int blockCount = 0;
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+
+    for (int i = 0; i < blockCount; i++) {
+        char name[64];
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(this->ID, i, sizeof(name), &length, name);
+        const string_view blockName(name, length);
+
+        const auto block = ranges::find(uniformBlocks, blockName, &UniformBlockInfo::name);
+        if (block == uniformBlocks.end()) {
+            SDL_LogError(0, "Shader error: Unknown uniform block %s", name);
+            return false;
+        }
+
+        // Drivers may or may not pad the reported size to a vec4, any other size means the GLSL block and its
+        // struct have different members. The offsets are checked by the static_asserts of UniformBlock.h.
+        int size = 0;
+        glGetActiveUniformBlockiv(this->ID, i, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+        if (static_cast<size_t>(size) != block->size && static_cast<size_t>(size) != std140::roundUp(block->size, 16)) {
+            SDL_LogError(0, "Shader error: Uniform block %s is %i bytes, its struct is %zu", name, size, block->size);
+            return false;
+        }
+
+        glUniformBlockBinding(this->ID, i, static_cast<unsigned int>(block->binding));
+    }
+    return true;
+}
+
+UniformHandle Shader::uniform(const string_view name) const {
+    const uint64_t hash = hashString(name);
+
+    // Entries are sorted by hash, and the name check deals with the (unlikely) collisions
+    auto it = ranges::lower_bound(this->uniforms, hash, {}, &UniformEntry::hash);
+    for (; it != this->uniforms.end() && it->hash == hash; ++it) {
+        if (it->name == name) {
+            return {it->location};
+        }
+    }
+    return {};
+}
+
 void Shader::use() const {
     glUseProgram(this->ID);
 }
 
 void Shader::setBool(const std::string &name, const bool value) const {
-    glUniform1i(glGetUniformLocation(this->ID, name.c_str()), value);
+    this->setBool(this->uniform(name), value);
 }
 
 void Shader::setInt(const std::string &name, const int value) const {
-    glUniform1i(glGetUniformLocation(this->ID, name.c_str()), value);
+    this->setInt(this->uniform(name), value);
 }
 
 void Shader::setFloat(const std::string &name, const float value) const {
-    glUniform1f(glGetUniformLocation(this->ID, name.c_str()), value);
+    this->setFloat(this->uniform(name), value);
+}
+
+void Shader::setBool(const UniformHandle handle, const bool value) const {
+    glUniform1i(handle.location, value);
+}
+
+void Shader::setInt(const UniformHandle handle, const int value) const {
+    glUniform1i(handle.location, value);
+}
+
+void Shader::setFloat(const UniformHandle handle, const float value) const {
+    glUniform1f(handle.location, value);
 }
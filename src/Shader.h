@@ -1,26 +1,124 @@
 #ifndef OPENGL_TEST_SHADER_H
 #define OPENGL_TEST_SHADER_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "SDL3/SDL.h"
 
+class ProgramCache;
+
+// Location of a uniform, looked up once so that setting it every frame costs no string work
+struct UniformHandle {
+    int location = -1;
+
+    bool valid() const { return location != -1; }
+};
+
+struct UniformEntry {
+    uint64_t hash{};
+    int location = -1;
+    std::string name;
+};
+
+enum class ShaderStatus {
+    Empty,
+    // Sources read, waiting for submit()
+    Loaded,
+    // Handed to the driver, waiting for finish()
+    Compiling,
+    Ready,
+    Failed,
+};
+
+/**
+ * A vertex and fragment shader program.
+ *
+ * init() builds it in one go. To build several programs at once (see ShaderBatch), the steps can be
+ * run separately: load() reads the sources, submit() hands them to the driver without waiting,
+ * isReady() polls it, and finish() checks the results.
+ */
 class Shader {
 public:
+    // Set by enableParallelCompile() when the driver compiles on its own threads
+    inline static bool parallelCompile = false;
+
     unsigned int ID{};
+    ShaderStatus status = ShaderStatus::Empty;
+    // Kept to rebuild the program when a source changes
+    std::string vertexPath;
+    std::string fragmentPath;
+    // Injected after the #version line of both sources, see ShaderVariants
+    std::string defines;
+    // Every file each stage was built from, its source then its includes, so that a change
+    // to an included file rebuilds the programs including it and nothing else
+    std::vector<std::string> vertexFiles;
+    std::vector<std::string> fragmentFiles;
+
+    // Every active uniform of the program, sorted by name hash
+    std::vector<UniformEntry> uniforms;
+
+    // Between load() and finish()
+    std::string vertexCode;
+    std::string fragmentCode;
+    unsigned int vertexShader{};
+    unsigned int fragmentShader{};
+    uint64_t cacheKey{};
+    bool loadedFromCache = false;
+
+    // Asks the driver for background compilation through KHR/ARB_parallel_shader_compile, if it has it
+    static void enableParallelCompile();
 
-    // Constructor reads and builds the shader from the specified paths
-    SDL_AppResult init(const char *vertexPath, const char *fragmentPath);
+    // Reads and builds the shader from the specified paths,
+    // or loads the program binary from the cache when the sources didn't change
+    SDL_AppResult init(
+        const char *vertexPath, const char *fragmentPath,
+        const ProgramCache *cache = nullptr, std::string_view defines = {}
+    );
+
+    SDL_AppResult load(const char *vertexPath, const char *fragmentPath, std::string_view defines = {});
+
+    // Starts compiling and linking, or loads the cached binary
+    void submit(const ProgramCache *cache = nullptr);
+
+    // Whether finish() would return without waiting, always true without parallel compilation
+    bool isReady() const;
+
+    // Checks the compile and link results, waiting for the driver if it isn't done yet
+    SDL_AppResult finish(const ProgramCache *cache = nullptr);
+
+    // Whether fileName is the file name of one of the sources or of a file they include
+    bool uses(std::string_view fileName) const;
+
+    void destroy();
 
     // Use/activate the shader
     void use() const;
 
+    // Returns the handle of a uniform, or an invalid handle if the program has no such active uniform
+    UniformHandle uniform(std::string_view name) const;
+
     // Utility uniform functions
     void setBool(const std::string &name, bool value) const;
 
     void setInt(const std::string &name, int value) const;
 
     void setFloat(const std::string &name, float value) const;
+
+    void setBool(UniformHandle handle, bool value) const;
+
+    void setInt(UniformHandle handle, int value) const;
+
+    void setFloat(UniformHandle handle, float value) const;
+
+private:
+    // Fills the uniform table from the linked program
+    void reflectUniforms();
+
+    // Binds the program's uniform blocks to their fixed binding points, fails if one doesn't match its C++ struct
+    bool bindUniformBlocks() const;
 };
 
 
@@ -0,0 +1,42 @@
+#include "ShaderBatch.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void ShaderBatch::add(Shader &shader, const char *vertexPath, const char *fragmentPath, const string_view defines) {
+    this->entries.push_back({&shader, vertexPath, fragmentPath, string(defines)});
+}
+
+SDL_AppResult ShaderBatch::compile(const ProgramCache *cache) {
+    const uint64_t start = SDL_GetPerformanceCounter();
+
+    SDL_AppResult result = SDL_APP_CONTINUE;
+    vector<Shader *> pending;
+    for (const auto &entry: this->entries) {
+        if (entry.shader->load(entry.vertexPath.c_str(), entry.fragmentPath.c_str(), entry.defines) == SDL_APP_FAILURE) {
+            result = SDL_APP_FAILURE;
+            continue;
+        }
+        entry.shader->submit(cache);
+        pending.push_back(entry.shader);
+    }
+
+    // Finish programs in whatever order the driver completes them
+    while (not pending.empty()) {
+        const auto ready = ranges::find_if(pending, &Shader::isReady);
+        if (ready == pending.end()) {
+            SDL_Delay(1);
+            continue;
+        }
+        if ((*ready)->finish(cache) == SDL_APP_FAILURE) {
+            result = SDL_APP_FAILURE;
+        }
+        pending.erase(ready);
+    }
+
+    const double milliseconds = static_cast<double>(SDL_GetPerformanceCounter() - start) * 1000.0
+                                / static_cast<double>(SDL_GetPerformanceFrequency());
+    SDL_Log("Shader batch: %zu programs built in %.2f ms", this->entries.size(), milliseconds);
+    return result;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#ifndef OPENGL_TEST_SHADERBATCH_H
+#define OPENGL_TEST_SHADERBATCH_H
+
+#include <string>
+#include <vector>
+
+#include "SDL3/SDL.h"
+
+#include "Shader.h"
+
+class ProgramCache;
+
+/**
+ * Builds several programs at once: every program is submitted before any result is checked, so a
+ * driver with parallel shader compilation works on all of them at the same time instead of one
+ * after the other. Without it, this is the same as calling Shader::init on each program.
+ */
+class ShaderBatch {
+public:
+    struct Entry {
+        Shader *shader{};
+        std::string vertexPath;
+        std::string fragmentPath;
+        std::string defines;
+    };
+
+    std::vector<Entry> entries;
+
+    void add(Shader &shader, const char *vertexPath, const char *fragmentPath, std::string_view defines = {});
+
+    // Fails if any program fails to build, after logging every failure
+    SDL_AppResult compile(const ProgramCache *cache = nullptr);
+};
+
+
+#endif //OPENGL_TEST_SHADERBATCH_H
@@ -0,0 +1,91 @@
+#include "ShaderPreprocessor.h"
+
+#include <algorithm>
+#include <string_view>
+
+#include "SDL3/SDL_log.h"
+
+#include "Assets.h"
+
+using namespace std;
+
+// Deep enough for any sane include chain, low enough to stop an include cycle quickly
+constexpr int maxIncludeDepth = 16;
+
+static string_view trimLeft(const string_view text) {
+    const size_t start = text.find_first_not_of(" \t");
+    return start == string_view::npos ? string_view{} : text.substr(start);
+}
+
+// Returns the quoted file name of an #include line, or an empty view if the line isn't one
+static string_view includedFile(const string_view line) {
+    const string_view trimmed = trimLeft(line);
+    if (not trimmed.starts_with('#')) {
+        return {};
+    }
+    const string_view directive = trimLeft(trimmed.substr(1));
+    if (not directive.starts_with("include")) {
+        return {};
+    }
+
+    const string_view argument = trimLeft(directive.substr(7));
+    const size_t end = argument.find('"', 1);
+    if (not argument.starts_with('"') || end == string_view::npos) {
+        return {};
+    }
+    return argument.substr(1, end - 1);
+}
+
+bool ShaderPreprocessor::process(const string &path, PreprocessedSource &source) const {
+    source.code.clear();
+    source.files.clear();
+    return this->append(path, source, 0);
+}
+
+bool ShaderPreprocessor::append(const string &path, PreprocessedSource &source, const int depth) const {
+    if (depth > maxIncludeDepth) {
+        SDL_LogError(0, "Shader error: Includes nested too deep in %s", path.c_str());
+        return false;
+    }
+
+    AssetData asset;
+    if (not Assets::read(path, asset)) {
+        SDL_LogError(0, "Shader error: File not successfully read: %s", path.c_str());
+        return false;
+    }
+    const string_view text = asset.text();
+
+    const size_t fileIndex = source.files.size();
+    source.files.push_back(path);
+
+    size_t lineNumber = 1;
+    for (size_t start = 0; start < text.size(); lineNumber++) {
+        size_t end = text.find('\n', start);
+        if (end == string_view::npos) {
+            end = text.size();
+        }
+        const string_view line = text.substr(start, end - start);
+        start = end + 1;
+
+        const string_view include = includedFile(line);
+        if (include.empty()) {
+            source.code += line;
+            source.code += '\n';
+            continue;
+        }
+
+        const string includePath = this->directory + "/" + string(include);
+        if (ranges::find(source.files, includePath) != source.files.end()) {
+            // Already included, an empty line keeps the line count
+            source.code += '\n';
+            continue;
+        }
+
+        source.code += "#line 1 " + to_string(source.files.size()) + "\n";
+        if (not this->append(includePath, source, depth + 1)) {
+            return false;
+        }
+        source.code += "#line " + to_string(lineNumber + 1) + " " + to_string(fileIndex) + "\n";
+    }
+    return true;
+}
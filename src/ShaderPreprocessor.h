@@ -0,0 +1,38 @@
+#pragma once
+
+#ifndef OPENGL_TEST_SHADERPREPROCESSOR_H
+#define OPENGL_TEST_SHADERPREPROCESSOR_H
+
+#include <string>
+#include <vector>
+
+struct PreprocessedSource {
+    std::string code;
+    // Every file the code was built from, the index is the source string number of its #line directives
+    std::vector<std::string> files;
+};
+
+/**
+ * Resolves `#include "file"` directives in GLSL, which has no include support of its own.
+ *
+ * Included paths are relative to the shaders directory. Each file is included once at most, later
+ * includes of the same file are dropped, as if every file had an include guard. #line directives
+ * keep the line numbers of compile errors right, with the index of the file in place of the
+ * source string number. Includes are resolved unconditionally, even inside an #ifdef.
+ */
+class ShaderPreprocessor {
+public:
+    std::string directory;
+
+    explicit ShaderPreprocessor(std::string directory) : directory(std::move(directory)) {
+    }
+
+    // Logs the failure and returns false when a file can't be read
+    bool process(const std::string &path, PreprocessedSource &source) const;
+
+private:
+    bool append(const std::string &path, PreprocessedSource &source, int depth) const;
+};
+
+
+#endif //OPENGL_TEST_SHADERPREPROCESSOR_H
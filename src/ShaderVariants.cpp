@@ -0,0 +1,64 @@
+#include "ShaderVariants.h"
+
+#include "ShaderBatch.h"
+
+using namespace std;
+
+void ShaderVariants::init(const char *vertexPath, const char *fragmentPath, const ProgramCache *cache) {
+    this->vertexPath = vertexPath;
+    this->fragmentPath = fragmentPath;
+    this->cache = cache;
+}
+
+string ShaderVariants::definesFor(const ShaderFeatures features) {
+    string defines;
+    for (size_t bit = 0; bit < shaderFeatureNames.size(); bit++) {
+        if (features & (1u << bit)) {
+            defines += "#define " + string(shaderFeatureNames[bit]) + "\n";
+        }
+    }
+    return defines;
+}
+
+SDL_AppResult ShaderVariants::prewarm(const span<const ShaderFeatures> features) {
+    ShaderBatch batch;
+    vector<Shader *> built;
+    for (const ShaderFeatures variant: features) {
+        auto &shader = this->variants[variant];
+        if (shader) {
+            continue;
+        }
+        shader = make_unique<Shader>();
+        batch.add(*shader, this->vertexPath.c_str(), this->fragmentPath.c_str(), definesFor(variant));
+        built.push_back(shader.get());
+    }
+
+    const SDL_AppResult result = batch.compile(this->cache);
+    for (Shader *shader: built) {
+        if (shader->status == ShaderStatus::Ready && this->configure) {
+            this->configure(*shader);
+        }
+    }
+    return result;
+}
+
+Shader *ShaderVariants::get(const ShaderFeatures features) {
+    auto &shader = this->variants[features];
+    if (not shader) {
+        shader = make_unique<Shader>();
+        const string defines = definesFor(features);
+        if (shader->init(this->vertexPath.c_str(), this->fragmentPath.c_str(), this->cache, defines) == SDL_APP_CONTINUE) {
+            if (this->configure) {
+                this->configure(*shader);
+            }
+        }
+    }
+    return shader->status == ShaderStatus::Ready ? shader.get() : nullptr;
+}
+
+void ShaderVariants::destroy() {
+    for (auto &[features, shader]: this->variants) {
+        shader->destroy();
+    }
+    this->variants.clear();
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#ifndef OPENGL_TEST_SHADERVARIANTS_H
+#define OPENGL_TEST_SHADERVARIANTS_H
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "SDL3/SDL.h"
+
+#include "Shader.h"
+
+class ProgramCache;
+
+// Feature bits of a shader variant, each one becomes a #define of the same name
+enum ShaderFeature : uint32_t {
+    // Samples ourTexture
+    SHADER_TEXTURED = 1 << 0,
+    // Multiplies by the per vertex color
+    SHADER_VERTEX_COLOR = 1 << 1,
+    // Reads the SpriteInstance attributes
+    SHADER_INSTANCED = 1 << 2,
+    // Samples ourTexture as a sampler2DArray at the instance layer, needs TEXTURED and INSTANCED
+    SHADER_TEXTURE_ARRAY = 1 << 3,
+};
+
+using ShaderFeatures = uint32_t;
+
+constexpr std::array<std::string_view, 4> shaderFeatureNames = {"TEXTURED", "VERTEX_COLOR", "INSTANCED", "TEXTURE_ARRAY"};
+
+/**
+ * Every program built from one pair of sources, one per combination of features.
+ *
+ * The sources pick their inputs and code paths with #ifdef, so each material only pays for what it
+ * uses instead of branching at runtime. Variants are compiled the first time they are asked for,
+ * or ahead of time with prewarm(), and kept by feature mask.
+ */
+class ShaderVariants {
+public:
+    std::string vertexPath;
+    std::string fragmentPath;
+    const ProgramCache *cache{};
+    // Sets the uniforms that never change, run on every variant once it is built
+    std::function<void(Shader &)> configure;
+
+    // Behind pointers so that a variant doesn't move when others are added
+    std::unordered_map<ShaderFeatures, std::unique_ptr<Shader>> variants;
+
+    void init(const char *vertexPath, const char *fragmentPath, const ProgramCache *cache = nullptr);
+
+    static std::string definesFor(ShaderFeatures features);
+
+    // Builds several variants at once through a ShaderBatch
+    SDL_AppResult prewarm(std::span<const ShaderFeatures> features);
+
+    // Returns the variant, building it if needed, or null if it fails to build (it won't be retried)
+    Shader *get(ShaderFeatures features);
+
+    void destroy();
+};
+
+
+#endif //OPENGL_TEST_SHADERVARIANTS_H
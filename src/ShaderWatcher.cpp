@@ -0,0 +1,115 @@
+#include "ShaderWatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <map>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "SDL3/SDL_log.h"
+
+using namespace std;
+
+bool ShaderWatcher::start(const string &directory) {
+    this->directory = directory;
+
+    int descriptor = -1;
+#ifdef __linux__
+    descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (descriptor == -1) {
+        SDL_LogError(0, "Shader watcher error: inotify_init1 failed");
+        return false;
+    }
+    // Editors either write the file in place or write a temporary file and rename it over
+    if (inotify_add_watch(descriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+        SDL_LogError(0, "Shader watcher error: Could not watch %s", directory.c_str());
+        close(descriptor);
+        return false;
+    }
+#endif
+
+    this->running = true;
+    this->thread = std::thread(&ShaderWatcher::loop, this, descriptor);
+    SDL_Log("Shader watcher: watching %s", directory.c_str());
+    return true;
+}
+
+void ShaderWatcher::stop() {
+    this->running = false;
+    if (this->thread.joinable()) {
+        this->thread.join();
+    }
+}
+
+vector<string> ShaderWatcher::takeChanges() {
+    vector<string> taken;
+    lock_guard lock(this->mutex);
+    taken.swap(this->changes);
+    return taken;
+}
+
+void ShaderWatcher::record(const string &name) {
+    lock_guard lock(this->mutex);
+    if (ranges::find(this->changes, name) == this->changes.end()) {
+        this->changes.push_back(name);
+    }
+}
+
+#ifdef __linux__
+
+void ShaderWatcher::loop(const int descriptor) {
+    // Large enough for a burst of events, each one is a header followed by the file name
+    alignas(inotify_event) char buffer[4096];
+
+    while (this->running) {
+        // Wakes up regularly to notice stop()
+        pollfd pollDescriptor{descriptor, POLLIN, 0};
+        if (poll(&pollDescriptor, 1, 100) <= 0) {
+            continue;
+        }
+
+        ssize_t length;
+        while ((length = read(descriptor, buffer, sizeof(buffer))) > 0) {
+            for (ssize_t offset = 0; offset < length;) {
+                const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+                if (event->len > 0) {
+                    this->record(event->name);
+                }
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            }
+        }
+    }
+
+    close(descriptor);
+}
+
+#else
+
+void ShaderWatcher::loop(int) {
+    map<string, filesystem::file_time_type> writeTimes;
+    bool firstScan = true;
+
+    while (this->running) {
+        error_code error;
+        for (const auto &entry: filesystem::directory_iterator(this->directory, error)) {
+            const auto writeTime = entry.last_write_time(error);
+            auto [it, inserted] = writeTimes.try_emplace(entry.path().filename().string(), writeTime);
+            if (not inserted && it->second != writeTime) {
+                it->second = writeTime;
+                this->record(it->first);
+            } else if (inserted && not firstScan) {
+                this->record(it->first);
+            }
+        }
+        firstScan = false;
+
+        this_thread::sleep_for(chrono::milliseconds(500));
+    }
+}
+
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#ifndef OPENGL_TEST_SHADERWATCHER_H
+#define OPENGL_TEST_SHADERWATCHER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Watches the shader directory on a background thread and collects the names of the files that
+ * changed, for the renderer to rebuild the programs using them at the start of its next frame.
+ *
+ * Uses inotify on Linux, and polls modification times every half second elsewhere.
+ */
+class ShaderWatcher {
+public:
+    std::string directory;
+    std::thread thread;
+    std::atomic<bool> running = false;
+    std::mutex mutex;
+    // File names relative to directory, without duplicates
+    std::vector<std::string> changes;
+
+    bool start(const std::string &directory);
+
+    void stop();
+
+    // Returns the files changed since the last call, never blocks on the watcher thread for long
+    std::vector<std::string> takeChanges();
+
+private:
+    void record(const std::string &name);
+
+    void loop(int descriptor);
+};
+
+
+#endif //OPENGL_TEST_SHADERWATCHER_H
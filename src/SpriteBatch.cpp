@@ -0,0 +1,71 @@
+#include "SpriteBatch.h"
+
+#include <cstddef>
+
+#include "glbinding/gl33core/gl.h"
+
+using namespace std;
+using namespace gl33core;
+
+// Points the instance attributes at the instances written at offset in the stream buffer
+static void setInstanceAttributes(const size_t offset) {
+    const auto pointer = [offset](const size_t member) {
+        return reinterpret_cast<void *>(offset + member);
+    };
+
+    // Transform attribute (position and scale)
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), pointer(offsetof(SpriteInstance, position)));
+    // Rotation and layer attribute
+    glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), pointer(offsetof(SpriteInstance, rotation)));
+    // Tint attribute
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), pointer(offsetof(SpriteInstance, tint)));
+    // Texture rectangle attribute
+    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), pointer(offsetof(SpriteInstance, uvRect)));
+}
+
+void SpriteBatch::init(const unsigned int quadVertexBuffer, const unsigned int quadIndexBuffer, StreamBuffer &stream) {
+    this->stream = &stream;
+
+    glGenVertexArrays(1, &this->VAO);
+    glBindVertexArray(this->VAO);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIndexBuffer);
+
+    // Same layout as the quad of RenderEngine, we only need positions and texture coordinates
+    glBindBuffer(GL_ARRAY_BUFFER, quadVertexBuffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *) 0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *) (6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    // The instance attributes move around the stream buffer, draw() points them at each frame's data
+    glBindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+    setInstanceAttributes(0);
+    for (const unsigned int location: {3u, 4u, 5u, 6u}) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+
+    glBindVertexArray(0);
+}
+
+void SpriteBatch::draw(GLStateCache &state, const span<const SpriteInstance> instances) {
+    if (instances.empty()) {
+        return;
+    }
+
+    const auto allocation = this->stream->write(instances.data(), instances.size_bytes());
+
+    state.bindVertexArray(this->VAO);
+    state.bindBuffer(BufferTarget::Array, allocation.buffer);
+    setInstanceAttributes(allocation.offset);
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(instances.size()));
+}
+
+void SpriteBatch::destroy() {
+    if (this->VAO) {
+        glDeleteVertexArrays(1, &this->VAO);
+    }
+    this->VAO = 0;
+    this->stream = nullptr;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#ifndef OPENGL_TEST_SPRITEBATCH_H
+#define OPENGL_TEST_SPRITEBATCH_H
+
+#include <cstddef>
+#include <span>
+
+#include "GLStateCache.h"
+#include "StreamBuffer.h"
+
+// Per instance data, laid out exactly as the instance attributes of shaders/shader.vsh built with SHADER_INSTANCED
+struct SpriteInstance {
+    // Center of the sprite, in normalized device coordinates
+    float position[2]{};
+    // Size of the sprite, in normalized device coordinates
+    float scale[2]{1.0f, 1.0f};
+    // In radians
+    float rotation{};
+    float layer{};
+    float tint[4]{1.0f, 1.0f, 1.0f, 1.0f};
+    // Part of the texture the quad shows, xy: offset, zw: size (see AtlasRegion)
+    float uvRect[4]{0.0f, 0.0f, 1.0f, 1.0f};
+};
+
+/**
+ * Draws any number of textured quads with a single glDrawElementsInstanced call.
+ * The quad geometry is shared with the engine, only the per instance attributes are written each frame,
+ * straight into a StreamBuffer.
+ */
+class SpriteBatch {
+public:
+    unsigned int VAO{};
+    StreamBuffer *stream{};
+
+    // Builds the vertex array from the quad buffers (positions at location 0, texture coordinates at location 2)
+    void init(unsigned int quadVertexBuffer, unsigned int quadIndexBuffer, StreamBuffer &stream);
+
+    void draw(GLStateCache &state, std::span<const SpriteInstance> instances);
+
+    void destroy();
+};
+
+
+#endif //OPENGL_TEST_SPRITEBATCH_H
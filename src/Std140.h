@@ -0,0 +1,173 @@
+#pragma once
+
+#ifndef OPENGL_TEST_STD140_H
+#define OPENGL_TEST_STD140_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/**
+ * C++ types whose size and alignment follow the std140 rules, so that a struct made of them
+ * has the exact layout GLSL gives the matching `layout (std140) uniform` block.
+ *
+ * vec3 is left out on purpose: std140 packs a following scalar into its fourth component,
+ * which no C++ type can express. Use a vec4, or a vec2 and a float.
+ *
+ * A block struct is described by a list of STD140_MEMBER() entries, in declaration order. layout()
+ * generates the std140 offsets from the member types alone, and matches() checks them against where
+ * the compiler put each member, and that the list names every member of the struct.
+ */
+namespace std140 {
+    using float_ = float;
+    using int_ = int32_t;
+    using uint = uint32_t;
+    // GLSL bools are 4 bytes wide
+    using bool_ = uint32_t;
+
+    struct alignas(8) vec2 {
+        float x{}, y{};
+    };
+
+    struct alignas(16) vec4 {
+        float x{}, y{}, z{}, w{};
+    };
+
+    // Column major, each column aligned like a vec4
+    struct alignas(16) mat4 {
+        vec4 columns[4]{};
+
+        static constexpr mat4 identity() {
+            return {{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}}};
+        }
+    };
+
+    // Array elements are padded to a multiple of 16 bytes
+    template<typename T, size_t N>
+    struct array {
+        struct alignas(16) Element {
+            T value{};
+        };
+
+        Element elements[N]{};
+
+        constexpr T &operator[](const size_t i) { return this->elements[i].value; }
+        constexpr const T &operator[](const size_t i) const { return this->elements[i].value; }
+    };
+
+    static_assert(sizeof(vec2) == 8 && alignof(vec2) == 8);
+    static_assert(sizeof(vec4) == 16 && alignof(vec4) == 16);
+    static_assert(sizeof(mat4) == 64 && alignof(mat4) == 16);
+    static_assert(sizeof(array<float, 3>) == 48);
+
+    // What a block struct must satisfy on top of being made of the types above
+    template<typename T>
+    constexpr bool isBlock = std::is_standard_layout_v<T>
+                             && std::is_trivially_copyable_v<T>
+                             && alignof(T) == 16
+                             && sizeof(T) % 16 == 0;
+
+    constexpr size_t roundUp(const size_t value, const size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Base alignment and size the std140 rules give a type, only defined for the types above
+    struct Rules {
+        size_t alignment;
+        size_t size;
+    };
+
+    template<typename T>
+    constexpr Rules rules = {};
+
+    template<>
+    constexpr Rules rules<float> = {4, 4};
+    template<>
+    constexpr Rules rules<int32_t> = {4, 4};
+    template<>
+    constexpr Rules rules<uint32_t> = {4, 4};
+    template<>
+    constexpr Rules rules<vec2> = {8, 8};
+    template<>
+    constexpr Rules rules<vec4> = {16, 16};
+    template<>
+    constexpr Rules rules<mat4> = {16, 64};
+    template<typename T, size_t N>
+    constexpr Rules rules<array<T, N>> = {16, roundUp(rules<T>.size, 16) * N};
+
+    struct Member {
+        std::string_view name;
+        Rules rules;
+        // Where the C++ struct has it
+        size_t offset;
+    };
+
+    template<size_t N>
+    struct Layout {
+        std::array<size_t, N> offsets{};
+        // End of the last member, what drivers report before padding the block to a vec4 (if they do)
+        size_t size{};
+    };
+
+    // The std140 offsets of members laid out in order
+    template<size_t N>
+    constexpr Layout<N> layout(const std::array<Member, N> &members) {
+        Layout<N> result;
+        size_t offset = 0;
+        for (size_t i = 0; i < N; i++) {
+            offset = roundUp(offset, members[i].rules.alignment);
+            result.offsets[i] = offset;
+            offset += members[i].rules.size;
+        }
+        result.size = offset;
+        return result;
+    }
+
+    // Converts to any member type, only used to count the members of an aggregate
+    struct AnyMember {
+        template<typename T>
+        operator T() const;
+    };
+
+    template<size_t>
+    using AnyMemberAt = AnyMember;
+
+    template<typename T, size_t... I>
+    constexpr bool initializableWith(std::index_sequence<I...>) {
+        return requires { T{AnyMemberAt<I>{}...}; };
+    }
+
+    template<typename T, size_t N = 0>
+    constexpr size_t memberCount() {
+        if constexpr (initializableWith<T>(std::make_index_sequence<N + 1>{})) {
+            return memberCount<T, N + 1>();
+        } else {
+            return N;
+        }
+    }
+
+    // True when members lists every member of T, each where std140 puts it
+    template<typename T, size_t N>
+    constexpr bool matches(const std::array<Member, N> &members) {
+        const Layout<N> generated = layout(members);
+        if (memberCount<T>() != N || sizeof(T) != roundUp(generated.size, 16)) {
+            return false;
+        }
+        for (size_t i = 0; i < N; i++) {
+            if (members[i].rules.size == 0 || members[i].offset != generated.offsets[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+// An entry of a block's member list, see std140::matches
+#define STD140_MEMBER(Block, member) \
+    std140::Member{#member, std140::rules<decltype(Block::member)>, offsetof(Block, member)}
+
+
+#endif //OPENGL_TEST_STD140_H
@@ -0,0 +1,190 @@
+#include "StreamBuffer.h"
+
+#include <bit>
+#include <cstring>
+
+#include "SDL3/SDL.h"
+
+#include "glbinding/gl/gl.h"
+
+#include "glbinding-aux/ContextInfo.h"
+
+using namespace std;
+using namespace gl;
+using namespace glbinding;
+
+// Mapping goes through a target the state cache doesn't track, so the cached bindings stay valid
+constexpr GLenum mapTarget = GL_COPY_WRITE_BUFFER;
+
+void StreamBuffer::init(const size_t regionSize, const size_t alignment) {
+    this->persistent = aux::ContextInfo::version() >= Version(4, 4)
+                       || aux::ContextInfo::extensions().contains(GLextension::GL_ARB_buffer_storage);
+    this->regionSize = regionSize;
+    this->alignment = alignment;
+    this->create();
+
+    SDL_Log(
+        "Stream buffer: %zu regions of %zu bytes, %s",
+        regionCount, this->regionSize, this->persistent ? "persistently mapped" : "mapped per allocation"
+    );
+}
+
+void StreamBuffer::create() {
+    const auto size = static_cast<GLsizeiptr>(this->regionSize * regionCount);
+
+    glGenBuffers(1, &this->buffer);
+    glBindBuffer(mapTarget, this->buffer);
+    if (this->persistent) {
+        // Coherent, so that writes are visible to the GPU without flushing
+        glBufferStorage(mapTarget, size, nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+        this->mapping = static_cast<byte *>(glMapBufferRange(
+            mapTarget, 0, size, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT
+        ));
+    } else {
+        glBufferData(mapTarget, size, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(mapTarget, 0);
+
+    this->region = 0;
+    this->offset = 0;
+}
+
+void StreamBuffer::release() {
+    for (auto &fence: this->fences) {
+        if (fence) {
+            glDeleteSync(static_cast<GLsync>(fence));
+            fence = nullptr;
+        }
+    }
+
+    if (this->buffer) {
+        if (this->mapping) {
+            glBindBuffer(mapTarget, this->buffer);
+            glUnmapBuffer(mapTarget);
+            glBindBuffer(mapTarget, 0);
+            this->mapping = nullptr;
+        }
+        // Draws already submitted keep the storage alive until they are done
+        glDeleteBuffers(1, &this->buffer);
+        this->buffer = 0;
+    }
+}
+
+void StreamBuffer::waitForRegion(const size_t index) {
+    const auto fence = static_cast<GLsync>(this->fences[index]);
+    if (not fence) {
+        return;
+    }
+
+    if (glClientWaitSync(fence, GL_NONE_BIT, 0) == GL_TIMEOUT_EXPIRED) {
+        // The GPU is more than regionCount frames behind, we have no choice but to wait
+        this->stalls++;
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+        }
+    }
+    glDeleteSync(fence);
+    this->fences[index] = nullptr;
+}
+
+StreamAllocation StreamBuffer::mapOverflow(const size_t size) {
+    // A fresh buffer, nothing can be using it
+    unsigned int overflow = 0;
+    glGenBuffers(1, &overflow);
+    glBindBuffer(mapTarget, overflow);
+    glBufferData(mapTarget, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_DRAW);
+    void *data = glMapBufferRange(mapTarget, 0, static_cast<GLsizeiptr>(size), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    this->rangeMapped = data != nullptr;
+    this->rangeBound = true;
+    this->overflowBuffers.push_back(overflow);
+    return {data, overflow, 0, size};
+}
+
+StreamAllocation StreamBuffer::map(const size_t size) {
+    const auto align = [this](const size_t value) { return (value + this->alignment - 1) & ~(this->alignment - 1); };
+    this->requested = align(this->requested) + size;
+
+    const size_t start = align(this->offset);
+    if (start + size > this->regionSize) {
+        // The ranges bound earlier this frame point into our buffer, so it can only grow once the frame ends
+        return this->mapOverflow(size);
+    }
+    this->offset = start + size;
+
+    const size_t bufferOffset = this->region * this->regionSize + start;
+    if (this->persistent) {
+        return {this->mapping + bufferOffset, this->buffer, bufferOffset, size};
+    }
+
+    // The region fence already guarantees the GPU is done with this range
+    glBindBuffer(mapTarget, this->buffer);
+    void *data = glMapBufferRange(
+        mapTarget, static_cast<GLintptr>(bufferOffset), static_cast<GLsizeiptr>(size),
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+    );
+    this->rangeMapped = data != nullptr;
+    this->rangeBound = true;
+    return {data, this->buffer, bufferOffset, size};
+}
+
+void StreamBuffer::unmap() {
+    if (this->rangeMapped) {
+        glUnmapBuffer(mapTarget);
+        this->rangeMapped = false;
+    }
+    if (this->rangeBound) {
+        glBindBuffer(mapTarget, 0);
+        this->rangeBound = false;
+    }
+}
+
+StreamAllocation StreamBuffer::write(const void *data, const size_t size) {
+    auto allocation = this->map(size);
+    if (allocation.data) {
+        memcpy(allocation.data, data, size);
+    }
+    this->unmap();
+    allocation.data = nullptr;
+    return allocation;
+}
+
+void StreamBuffer::endFrame(GLStateCache &state) {
+    // Draws already submitted keep the storage of the overflow buffers alive until they are done
+    for (const unsigned int overflow: this->overflowBuffers) {
+        state.forgetBuffer(overflow);
+    }
+    glDeleteBuffers(static_cast<GLsizei>(this->overflowBuffers.size()), this->overflowBuffers.data());
+    this->overflowBuffers.clear();
+
+    if (this->requested > this->regionSize) {
+        // This frame needed more than a region, the next ones start over with a bigger buffer
+        state.forgetBuffer(this->buffer);
+        this->release();
+        this->regionSize = bit_ceil(this->requested);
+        this->grows++;
+        this->create();
+        this->requested = 0;
+        SDL_Log("Stream buffer: grown to %zu bytes per region", this->regionSize);
+        return;
+    }
+    this->requested = 0;
+
+    if (this->offset != 0) {
+        this->fences[this->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT);
+    }
+
+    this->region = (this->region + 1) % regionCount;
+    this->offset = 0;
+    this->waitForRegion(this->region);
+}
+
+void StreamBuffer::destroy(GLStateCache &state) {
+    for (const unsigned int overflow: this->overflowBuffers) {
+        state.forgetBuffer(overflow);
+    }
+    glDeleteBuffers(static_cast<GLsizei>(this->overflowBuffers.size()), this->overflowBuffers.data());
+    this->overflowBuffers.clear();
+    if (this->buffer) {
+        state.forgetBuffer(this->buffer);
+    }
+    this->release();
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#ifndef OPENGL_TEST_STREAMBUFFER_H
+#define OPENGL_TEST_STREAMBUFFER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "GLStateCache.h"
+
+struct StreamAllocation {
+    void *data{};
+    // The buffer to bind, the stream buffer itself unless the allocation overflowed its region
+    unsigned int buffer{};
+    // Offset of data in the buffer, to pass to glVertexAttribPointer or glBindBufferRange
+    size_t offset{};
+    size_t size{};
+};
+
+/**
+ * Ring buffer for data written every frame (instance attributes, uniforms), split in one region
+ * per frame in flight. Each region is fenced when its frame ends, and only written again once the
+ * GPU passed that fence, so writes never stall on the driver nor overwrite data still in use.
+ *
+ * With ARB_buffer_storage the whole buffer stays persistently mapped and allocations are plain
+ * pointer bumps. Without it, each allocation maps its range with GL_MAP_UNSYNCHRONIZED_BIT,
+ * the fences doing the synchronization the driver would otherwise do.
+ *
+ * A frame that needs more than a region gets its extra allocations from temporary buffers, and the
+ * ring grows at the end of the frame. Growing right away would delete the buffer under the ranges the
+ * frame already bound.
+ */
+class StreamBuffer {
+public:
+    static constexpr size_t regionCount = 3;
+
+    unsigned int buffer{};
+    bool persistent = false;
+    // Start of the persistent mapping, null when mapping per allocation
+    std::byte *mapping{};
+    size_t regionSize{};
+    size_t alignment{};
+    // GLsync objects, kept opaque so that GL headers don't leak out
+    std::array<void *, regionCount> fences{};
+    size_t region{};
+    size_t offset{};
+    // Bytes this frame asked for, overflow included, the size the next regions must have
+    size_t requested{};
+    // Allocations that didn't fit this frame, deleted once it ends
+    std::vector<unsigned int> overflowBuffers;
+    // Whether the last map() left a range mapped and a buffer bound to the mapping target
+    bool rangeMapped = false;
+    bool rangeBound = false;
+
+    // Statistics
+    uint64_t stalls{};
+    uint64_t grows{};
+
+    void init(size_t regionSize, size_t alignment = 16);
+
+    // The data must be written before the next map() and before the draw using it, then unmap()ped
+    StreamAllocation map(size_t size);
+
+    void unmap();
+
+    // Copies data into a new allocation, whose data pointer is null since it is already unmapped
+    StreamAllocation write(const void *data, size_t size);
+
+    // Fences the region of this frame and moves to the next one, once per frame after the last draw
+    void endFrame(GLStateCache &state);
+
+    void destroy(GLStateCache &state);
+
+private:
+    void create();
+
+    void release();
+
+    void waitForRegion(size_t index);
+
+    StreamAllocation mapOverflow(size_t size);
+};
+
+
+#endif //OPENGL_TEST_STREAMBUFFER_H
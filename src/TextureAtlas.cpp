@@ -0,0 +1,140 @@
+#include "TextureAtlas.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "SDL3/SDL.h"
+
+#include "glbinding/gl33core/gl.h"
+
+using namespace std;
+using namespace gl33core;
+
+// Padding texels shrink to one at this level, the ones below would mix neighbours together
+constexpr int maxLevel = bit_width(static_cast<unsigned>(TextureAtlas::padding)) - 1;
+
+// Images start on a multiple of padding, so their edges stay on texel boundaries down to maxLevel
+static int paddedSize(const int size) {
+    constexpr int padding = TextureAtlas::padding;
+    return (size + padding - 1) / padding * padding + 2 * padding;
+}
+
+// Copies the image into the middle of a rect sized block, repeating its edge texels all around
+static void extrude(const unsigned char *pixels, const int width, const int height, const AtlasRect &rect, vector<unsigned char> &block) {
+    block.resize(static_cast<size_t>(rect.width) * rect.height * 4);
+    for (int y = 0; y < rect.height; y++) {
+        const int sourceY = clamp(y - TextureAtlas::padding, 0, height - 1);
+        for (int x = 0; x < rect.width; x++) {
+            const int sourceX = clamp(x - TextureAtlas::padding, 0, width - 1);
+            memcpy(&block[(static_cast<size_t>(y) * rect.width + x) * 4], &pixels[(static_cast<size_t>(sourceY) * width + sourceX) * 4], 4);
+        }
+    }
+}
+
+void TextureAtlas::build(GLStateCache &state, const span<const AtlasImage> images) {
+    int maxSize = 0, maxLayers = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    this->layerSize = min(this->layerSize, maxSize);
+
+    // The placeholder comes first, then every image in order
+    struct Entry {
+        const char *name{};
+        const unsigned char *pixels{};
+        int width{};
+        int height{};
+        AtlasRect rect;
+        int layer{};
+    };
+    vector<Entry> entries;
+    entries.push_back({"placeholder", placeholderPixels, 2, 2, {}, 0});
+    for (const auto &image: images) {
+        entries.push_back({image.name.c_str(), image.pixels.empty() ? nullptr : image.pixels.data(), image.width, image.height, {}, 0});
+    }
+
+    // Tallest first, which is what the skyline packs best
+    vector<size_t> order(entries.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    ranges::stable_sort(order, [&entries](const size_t a, const size_t b) { return entries[a].height > entries[b].height; });
+
+    vector<SkylinePacker> packers;
+    for (const size_t index: order) {
+        auto &entry = entries[index];
+        if (not entry.pixels) {
+            continue;
+        }
+        const int width = paddedSize(entry.width), height = paddedSize(entry.height);
+
+        bool packed = false;
+        for (size_t layer = 0; layer < packers.size() && not packed; layer++) {
+            packed = packers[layer].insert(width, height, entry.rect);
+            entry.layer = static_cast<int>(layer);
+        }
+        if (not packed && static_cast<int>(packers.size()) < maxLayers) {
+            packers.emplace_back().init(this->layerSize, this->layerSize);
+            packed = packers.back().insert(width, height, entry.rect);
+            entry.layer = static_cast<int>(packers.size() - 1);
+        }
+        if (not packed) {
+            SDL_LogError(0, "Texture atlas error: %s (%ix%i) doesn't fit in a %ix%i layer",
+                         entry.name, entry.width, entry.height, this->layerSize, this->layerSize);
+            entry.pixels = nullptr;
+        }
+    }
+    this->layers = static_cast<int>(packers.size());
+
+    // Pixels come from client memory, not from a PBO the uploader left bound
+    state.bindBuffer(BufferTarget::PixelUnpack, 0);
+    glGenTextures(1, &this->texture);
+    state.bindTexture(0, TextureTarget::Texture2DArray, this->texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, static_cast<GLint>(GL_RGBA8), this->layerSize, this->layerSize, this->layers, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    const auto size = static_cast<float>(this->layerSize);
+    vector<unsigned char> block;
+    vector<AtlasRegion> packed(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        const auto &entry = entries[i];
+        if (not entry.pixels) {
+            continue;
+        }
+        extrude(entry.pixels, entry.width, entry.height, entry.rect, block);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, entry.rect.x, entry.rect.y, entry.layer, entry.rect.width, entry.rect.height, 1,
+                        GL_RGBA, GL_UNSIGNED_BYTE, block.data());
+
+        auto &region = packed[i];
+        region.uvRect[0] = static_cast<float>(entry.rect.x + padding) / size;
+        region.uvRect[1] = static_cast<float>(entry.rect.y + padding) / size;
+        region.uvRect[2] = static_cast<float>(entry.width) / size;
+        region.uvRect[3] = static_cast<float>(entry.height) / size;
+        region.layer = static_cast<float>(entry.layer);
+    }
+
+    this->placeholder = packed[0];
+    this->regions.clear();
+    for (size_t i = 1; i < entries.size(); i++) {
+        this->regions.push_back(entries[i].pixels ? packed[i] : this->placeholder);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, maxLevel);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(GL_LINEAR_MIPMAP_LINEAR));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(GL_LINEAR));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, static_cast<GLint>(GL_CLAMP_TO_EDGE));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, static_cast<GLint>(GL_CLAMP_TO_EDGE));
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    SDL_Log("Texture atlas: packed %zu images into %i layers of %ix%i", images.size(), this->layers, this->layerSize, this->layerSize);
+}
+
+void TextureAtlas::destroy(GLStateCache &state) {
+    if (this->texture) {
+        state.forgetTexture(this->texture);
+        glDeleteTextures(1, &this->texture);
+    }
+    this->texture = 0;
+    this->layers = 0;
+    this->regions.clear();
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#ifndef OPENGL_TEST_TEXTUREATLAS_H
+#define OPENGL_TEST_TEXTUREATLAS_H
+
+#include <span>
+#include <string>
+#include <vector>
+
+#include "AtlasPacker.h"
+#include "GLStateCache.h"
+
+// Magenta and black, so that a texture stuck on the placeholder is easy to spot
+constexpr unsigned char placeholderPixels[] = {
+    255, 0, 255, 255,   0, 0, 0, 255,
+    0, 0, 0, 255,   255, 0, 255, 255,
+};
+
+// A decoded RGBA8 image, bottom row first like GL expects
+struct AtlasImage {
+    std::string name;
+    int width{};
+    int height{};
+    // Empty when the image failed to load, it then gets the placeholder
+    std::vector<unsigned char> pixels;
+};
+
+// Where an image ended up, in the form the sprite instances take (see SpriteInstance)
+struct AtlasRegion {
+    // xy: offset, zw: size, in texture coordinates of the layer
+    float uvRect[4]{0.0f, 0.0f, 1.0f, 1.0f};
+    float layer{};
+};
+
+/**
+ * Packs many images into the layers of one GL_TEXTURE_2D_ARRAY, so that everything drawn from the
+ * atlas shares a single texture bind and can go out in a single instanced draw call.
+ *
+ * Images are packed with a SkylinePacker, a new layer is opened whenever one is full. Each image is
+ * surrounded by padding texels copied from its edges, and sits on a multiple of padding, so that
+ * filtering and the first log2(padding) mip levels never bleed between neighbours. Mipmaps stop there.
+ */
+class TextureAtlas {
+public:
+    static constexpr int padding = 4;
+
+    // Width and height of every layer, clamped to GL_MAX_TEXTURE_SIZE
+    int layerSize = 1024;
+    unsigned int texture{};
+    int layers{};
+    // One per image given to build(), in the same order
+    std::vector<AtlasRegion> regions;
+    // Stands in for the images that failed to load or don't fit in a layer
+    AtlasRegion placeholder;
+
+    // Packs and uploads every image at once, must run on the GL thread
+    void build(GLStateCache &state, std::span<const AtlasImage> images);
+
+    void destroy(GLStateCache &state);
+};
+
+
+#endif //OPENGL_TEST_TEXTUREATLAS_H
@@ -0,0 +1,324 @@
+#include "TextureFile.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// Keeps every size computation far from overflowing, no driver goes above this anyway
+constexpr int maxTextureSize = 1 << 15;
+
+constexpr TextureFormatInfo textureFormats[] = {
+    {formatRgba8, "RGBA8", 0, TextureCompression::None, false},
+    {formatSrgb8Alpha8, "SRGB8_ALPHA8", 0, TextureCompression::None, true},
+    {formatBc1, "BC1", 8, TextureCompression::S3tc, false},
+    {formatBc1Alpha, "BC1 (alpha)", 8, TextureCompression::S3tc, false},
+    {formatBc2, "BC2", 16, TextureCompression::S3tc, false},
+    {formatBc3, "BC3", 16, TextureCompression::S3tc, false},
+    {formatBc1Srgb, "BC1 sRGB", 8, TextureCompression::S3tc, true},
+    {formatBc1AlphaSrgb, "BC1 sRGB (alpha)", 8, TextureCompression::S3tc, true},
+    {formatBc2Srgb, "BC2 sRGB", 16, TextureCompression::S3tc, true},
+    {formatBc3Srgb, "BC3 sRGB", 16, TextureCompression::S3tc, true},
+    {formatBc4, "BC4", 8, TextureCompression::Rgtc, false},
+    {formatBc5, "BC5", 16, TextureCompression::Rgtc, false},
+    {formatBc7, "BC7", 16, TextureCompression::Bptc, false},
+    {formatBc7Srgb, "BC7 sRGB", 16, TextureCompression::Bptc, true},
+    {formatEtc2Rgb8, "ETC2 RGB8", 8, TextureCompression::Etc2, false},
+    {formatEtc2Srgb8, "ETC2 SRGB8", 8, TextureCompression::Etc2, true},
+    {formatEtc2Rgba8, "ETC2 RGBA8", 16, TextureCompression::Etc2, false},
+    {formatEtc2Srgb8Alpha8, "ETC2 SRGB8_ALPHA8", 16, TextureCompression::Etc2, true},
+};
+
+const TextureFormatInfo *formatInfo(const uint32_t internalFormat) {
+    for (const auto &info: textureFormats) {
+        if (info.internalFormat == internalFormat) {
+            return &info;
+        }
+    }
+    return nullptr;
+}
+
+size_t blockSize(const uint32_t internalFormat) {
+    const TextureFormatInfo *info = formatInfo(internalFormat);
+    return info ? info->blockSize : 0;
+}
+
+size_t imageSize(const uint32_t internalFormat, const int width, const int height) {
+    if (const size_t bytes = blockSize(internalFormat)) {
+        // Every dimension is rounded up to whole blocks, down to the 1x1 level
+        return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * bytes;
+    }
+    return static_cast<size_t>(width) * height * 4;
+}
+
+bool TextureCapabilities::supports(const uint32_t internalFormat) const {
+    const TextureFormatInfo *info = formatInfo(internalFormat);
+    if (not info) {
+        return false;
+    }
+    switch (info->compression) {
+        case TextureCompression::None: return true;
+        case TextureCompression::S3tc: return info->srgb ? this->s3tcSrgb : this->s3tc;
+        case TextureCompression::Rgtc: return this->rgtc;
+        case TextureCompression::Bptc: return this->bptc;
+        case TextureCompression::Etc2: return this->etc2;
+    }
+    return false;
+}
+
+// Fills texture.levels from back to back levels starting at offset, KTX prefixes each level with its size
+static bool readLevels(const span<const unsigned char> bytes, size_t offset, const uint32_t levelCount,
+                       const bool sizePrefixed, CookedTexture &texture, const char *&failureReason) {
+    int width = texture.width;
+    int height = texture.height;
+    for (uint32_t level = 0; level < levelCount; level++) {
+        const size_t size = imageSize(texture.internalFormat, width, height);
+        if (sizePrefixed) {
+            uint32_t storedSize = 0;
+            if (offset > bytes.size() || bytes.size() - offset < sizeof(storedSize)) {
+                failureReason = "truncated texture file";
+                return false;
+            }
+            memcpy(&storedSize, bytes.data() + offset, sizeof(storedSize));
+            offset += sizeof(storedSize);
+            if (storedSize != size) {
+                failureReason = "texture level size doesn't match its dimensions";
+                return false;
+            }
+        }
+        if (offset > bytes.size() || bytes.size() - offset < size) {
+            failureReason = "truncated texture file";
+            return false;
+        }
+        texture.levels.push_back({width, height, offset, size});
+
+        // KTX pads levels to 4 bytes
+        offset += sizePrefixed ? (size + 3) & ~size_t{3} : size;
+        if (width == 1 && height == 1 && level + 1 < levelCount) {
+            failureReason = "more texture levels than a full mip chain";
+            return false;
+        }
+        width = max(width / 2, 1);
+        height = max(height / 2, 1);
+    }
+    return true;
+}
+
+bool parseKtx(const span<const unsigned char> bytes, CookedTexture &texture, const char *&failureReason) {
+    KtxHeader header{};
+    if (bytes.size() < sizeof(header)) {
+        failureReason = "file too small for a KTX header";
+        return false;
+    }
+    memcpy(&header, bytes.data(), sizeof(header));
+
+    if (memcmp(header.identifier, ktxIdentifier, sizeof(ktxIdentifier)) != 0) {
+        failureReason = "not a KTX 1.1 file";
+        return false;
+    }
+    if (header.endianness != ktxEndianness) {
+        failureReason = "big endian KTX files are not supported";
+        return false;
+    }
+    if (header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth > 1
+        || header.numberOfArrayElements > 0 || header.numberOfFaces != 1) {
+        failureReason = "only single 2D textures are supported";
+        return false;
+    }
+    if (header.pixelWidth > maxTextureSize || header.pixelHeight > maxTextureSize) {
+        failureReason = "texture too large";
+        return false;
+    }
+
+    const TextureFormatInfo *info = formatInfo(header.glInternalFormat);
+    const bool uncompressed = info && info->blockSize == 0 && header.glFormat == pixelFormatRgba && header.glType == pixelTypeUnsignedByte;
+    const bool compressed = info && info->blockSize != 0 && header.glFormat == 0 && header.glType == 0;
+    if (not uncompressed && not compressed) {
+        failureReason = "unsupported KTX texture format";
+        return false;
+    }
+
+    texture = CookedTexture{};
+    texture.internalFormat = header.glInternalFormat;
+    texture.format = header.glFormat;
+    texture.type = header.glType;
+    texture.width = static_cast<int>(header.pixelWidth);
+    texture.height = static_cast<int>(header.pixelHeight);
+
+    // 0 means the file only has the base level and expects the mipmaps to be generated
+    const uint32_t levelCount = max(header.numberOfMipmapLevels, 1u);
+    const size_t offset = sizeof(header) + static_cast<size_t>(header.bytesOfKeyValueData);
+    return readLevels(bytes, offset, levelCount, true, texture, failureReason);
+}
+
+constexpr uint32_t fourCC(const char (&code)[5]) {
+    return static_cast<uint32_t>(code[0]) | static_cast<uint32_t>(code[1]) << 8
+           | static_cast<uint32_t>(code[2]) << 16 | static_cast<uint32_t>(code[3]) << 24;
+}
+
+constexpr uint32_t ddsMagic = fourCC("DDS ");
+constexpr uint32_t ddsMipMapCount = 0x20000;    // DDSD_MIPMAPCOUNT
+constexpr uint32_t ddsFourCC = 0x4;             // DDPF_FOURCC
+constexpr uint32_t ddsRgb = 0x40;               // DDPF_RGB
+constexpr uint32_t ddsCubemap = 0x200;          // DDSCAPS2_CUBEMAP
+constexpr uint32_t ddsVolume = 0x200000;        // DDSCAPS2_VOLUME
+constexpr uint32_t ddsTexture2D = 3;            // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+
+struct DdsPixelFormat {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t redMask;
+    uint32_t greenMask;
+    uint32_t blueMask;
+    uint32_t alphaMask;
+};
+
+struct DdsHeader {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    DdsPixelFormat pixelFormat;
+    uint32_t caps;
+    uint32_t caps2;
+    uint32_t caps3;
+    uint32_t caps4;
+    uint32_t reserved2;
+};
+
+struct DdsHeaderDx10 {
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+static_assert(sizeof(DdsHeader) == 128);
+static_assert(sizeof(DdsHeaderDx10) == 20);
+
+// internalFormat and pixel format of the DXGI formats we can upload, 0 when unsupported
+static pair<uint32_t, uint32_t> formatOfDxgi(const uint32_t dxgiFormat) {
+    switch (dxgiFormat) {
+        case 28: return {formatRgba8, pixelFormatRgba};             // R8G8B8A8_UNORM
+        case 29: return {formatSrgb8Alpha8, pixelFormatRgba};       // R8G8B8A8_UNORM_SRGB
+        case 87: return {formatRgba8, pixelFormatBgra};             // B8G8R8A8_UNORM
+        case 91: return {formatSrgb8Alpha8, pixelFormatBgra};       // B8G8R8A8_UNORM_SRGB
+        case 71: return {formatBc1Alpha, 0};                        // BC1_UNORM
+        case 72: return {formatBc1AlphaSrgb, 0};                    // BC1_UNORM_SRGB
+        case 74: return {formatBc2, 0};                             // BC2_UNORM
+        case 75: return {formatBc2Srgb, 0};                         // BC2_UNORM_SRGB
+        case 77: return {formatBc3, 0};                             // BC3_UNORM
+        case 78: return {formatBc3Srgb, 0};                         // BC3_UNORM_SRGB
+        case 80: return {formatBc4, 0};                             // BC4_UNORM
+        case 83: return {formatBc5, 0};                             // BC5_UNORM
+        case 98: return {formatBc7, 0};                             // BC7_UNORM
+        case 99: return {formatBc7Srgb, 0};                         // BC7_UNORM_SRGB
+        default: return {0, 0};
+    }
+}
+
+// Same as formatOfDxgi for the legacy pixel format description
+static pair<uint32_t, uint32_t> formatOfPixelFormat(const DdsPixelFormat &pixelFormat) {
+    if (pixelFormat.flags & ddsFourCC) {
+        switch (pixelFormat.fourCC) {
+            // DXT1 may use its transparent black, which only the alpha variant keeps
+            case fourCC("DXT1"): return {formatBc1Alpha, 0};
+            case fourCC("DXT2"):
+            case fourCC("DXT3"): return {formatBc2, 0};
+            case fourCC("DXT4"):
+            case fourCC("DXT5"): return {formatBc3, 0};
+            case fourCC("ATI1"):
+            case fourCC("BC4U"): return {formatBc4, 0};
+            case fourCC("ATI2"):
+            case fourCC("BC5U"): return {formatBc5, 0};
+            default: return {0, 0};
+        }
+    }
+    if ((pixelFormat.flags & ddsRgb) && pixelFormat.rgbBitCount == 32) {
+        if (pixelFormat.redMask == 0x000000ff && pixelFormat.greenMask == 0x0000ff00 && pixelFormat.blueMask == 0x00ff0000) {
+            return {formatRgba8, pixelFormatRgba};
+        }
+        if (pixelFormat.redMask == 0x00ff0000 && pixelFormat.greenMask == 0x0000ff00 && pixelFormat.blueMask == 0x000000ff) {
+            return {formatRgba8, pixelFormatBgra};
+        }
+    }
+    return {0, 0};
+}
+
+bool parseDds(const span<const unsigned char> bytes, CookedTexture &texture, const char *&failureReason) {
+    DdsHeader header{};
+    if (bytes.size() < sizeof(header)) {
+        failureReason = "file too small for a DDS header";
+        return false;
+    }
+    memcpy(&header, bytes.data(), sizeof(header));
+    if (header.magic != ddsMagic || header.size != sizeof(DdsHeader) - sizeof(header.magic)) {
+        failureReason = "not a DDS file";
+        return false;
+    }
+    if (header.width == 0 || header.height == 0 || (header.caps2 & (ddsCubemap | ddsVolume))) {
+        failureReason = "only single 2D textures are supported";
+        return false;
+    }
+    if (header.width > maxTextureSize || header.height > maxTextureSize) {
+        failureReason = "texture too large";
+        return false;
+    }
+
+    size_t offset = sizeof(header);
+    pair<uint32_t, uint32_t> format;
+    if ((header.pixelFormat.flags & ddsFourCC) && header.pixelFormat.fourCC == fourCC("DX10")) {
+        DdsHeaderDx10 dx10{};
+        if (bytes.size() < offset + sizeof(dx10)) {
+            failureReason = "truncated DDS file";
+            return false;
+        }
+        memcpy(&dx10, bytes.data() + offset, sizeof(dx10));
+        offset += sizeof(dx10);
+        if (dx10.resourceDimension != ddsTexture2D || dx10.arraySize > 1 || (dx10.miscFlag & 0x4)) {
+            failureReason = "only single 2D textures are supported";
+            return false;
+        }
+        format = formatOfDxgi(dx10.dxgiFormat);
+    } else {
+        format = formatOfPixelFormat(header.pixelFormat);
+    }
+    if (format.first == 0) {
+        failureReason = "unsupported DDS texture format";
+        return false;
+    }
+
+    texture = CookedTexture{};
+    texture.internalFormat = format.first;
+    texture.format = format.second;
+    texture.type = format.second ? pixelTypeUnsignedByte : 0;
+    texture.width = static_cast<int>(header.width);
+    texture.height = static_cast<int>(header.height);
+    texture.topDown = true;
+
+    const uint32_t levelCount = header.flags & ddsMipMapCount ? max(header.mipMapCount, 1u) : 1;
+    return readLevels(bytes, offset, levelCount, false, texture, failureReason);
+}
+
+bool parseTextureFile(const span<const unsigned char> bytes, CookedTexture &texture, const char *&failureReason) {
+    if (bytes.size() >= sizeof(ktxIdentifier) && memcmp(bytes.data(), ktxIdentifier, sizeof(ktxIdentifier)) == 0) {
+        return parseKtx(bytes, texture, failureReason);
+    }
+    uint32_t magic = 0;
+    if (bytes.size() >= sizeof(magic)) {
+        memcpy(&magic, bytes.data(), sizeof(magic));
+    }
+    if (magic == ddsMagic) {
+        return parseDds(bytes, texture, failureReason);
+    }
+    failureReason = "not a KTX or DDS file";
+    return false;
+}
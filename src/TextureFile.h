@@ -0,0 +1,141 @@
+#pragma once
+
+#ifndef OPENGL_TEST_TEXTUREFILE_H
+#define OPENGL_TEST_TEXTUREFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// GL enums as stored in texture files, spelled out so that the cooker doesn't need GL headers
+constexpr uint32_t pixelTypeUnsignedByte = 0x1401;      // GL_UNSIGNED_BYTE
+constexpr uint32_t pixelFormatRgb = 0x1907;             // GL_RGB
+constexpr uint32_t pixelFormatRgba = 0x1908;            // GL_RGBA
+constexpr uint32_t pixelFormatBgra = 0x80E1;            // GL_BGRA
+
+constexpr uint32_t formatRgba8 = 0x8058;                // GL_RGBA8
+constexpr uint32_t formatSrgb8Alpha8 = 0x8C43;          // GL_SRGB8_ALPHA8
+constexpr uint32_t formatBc1 = 0x83F0;                  // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+constexpr uint32_t formatBc1Alpha = 0x83F1;             // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+constexpr uint32_t formatBc2 = 0x83F2;                  // GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+constexpr uint32_t formatBc3 = 0x83F3;                  // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+constexpr uint32_t formatBc1Srgb = 0x8C4C;              // GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+constexpr uint32_t formatBc1AlphaSrgb = 0x8C4D;         // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+constexpr uint32_t formatBc2Srgb = 0x8C4E;              // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT
+constexpr uint32_t formatBc3Srgb = 0x8C4F;              // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+constexpr uint32_t formatBc4 = 0x8DBB;                  // GL_COMPRESSED_RED_RGTC1
+constexpr uint32_t formatBc5 = 0x8DBD;                  // GL_COMPRESSED_RG_RGTC2
+constexpr uint32_t formatBc7 = 0x8E8C;                  // GL_COMPRESSED_RGBA_BPTC_UNORM
+constexpr uint32_t formatBc7Srgb = 0x8E8D;              // GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+constexpr uint32_t formatEtc2Rgb8 = 0x9274;             // GL_COMPRESSED_RGB8_ETC2
+constexpr uint32_t formatEtc2Srgb8 = 0x9275;            // GL_COMPRESSED_SRGB8_ETC2
+constexpr uint32_t formatEtc2Rgba8 = 0x9278;            // GL_COMPRESSED_RGBA8_ETC2_EAC
+constexpr uint32_t formatEtc2Srgb8Alpha8 = 0x9279;      // GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC
+
+// What a driver needs to sample a format, see TextureCapabilities
+enum class TextureCompression {
+    None,
+    S3tc,
+    Rgtc,
+    Bptc,
+    Etc2,
+};
+
+struct TextureFormatInfo {
+    uint32_t internalFormat;
+    const char *name;
+    // Size of one 4x4 block, 0 for uncompressed formats
+    size_t blockSize;
+    TextureCompression compression;
+    bool srgb;
+};
+
+// Null for formats the loader doesn't know
+const TextureFormatInfo *formatInfo(uint32_t internalFormat);
+
+// Size in bytes of one 4x4 block of a compressed format, 0 for any other format
+size_t blockSize(uint32_t internalFormat);
+
+// Size in bytes of a width x height image in internalFormat
+size_t imageSize(uint32_t internalFormat, int width, int height);
+
+/**
+ * The compressed formats the current context can sample, filled by TextureLoader from the GL version and
+ * extensions. RGTC is core since GL 3.0, so it is always there.
+ */
+struct TextureCapabilities {
+    bool s3tc{};
+    bool s3tcSrgb{};
+    bool rgtc = true;
+    bool bptc{};
+    bool etc2{};
+
+    bool supports(uint32_t internalFormat) const;
+};
+
+constexpr unsigned char ktxIdentifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+constexpr uint32_t ktxEndianness = 0x04030201;
+
+struct KtxHeader {
+    unsigned char identifier[12];
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+static_assert(sizeof(KtxHeader) == 64);
+
+struct TextureLevel {
+    int width{};
+    int height{};
+    // Relative to the start of the file
+    size_t offset{};
+    size_t size{};
+};
+
+/**
+ * A texture stored in its GPU format with its whole mip chain, ready to upload level by level.
+ * Level data stays in the file it was parsed from.
+ */
+struct CookedTexture {
+    uint32_t internalFormat{};
+    // Both 0 for block compressed formats
+    uint32_t format{};
+    uint32_t type{};
+    int width{};
+    int height{};
+    std::vector<TextureLevel> levels;
+    // DDS files store the top row first, GL and the rest of our textures want the bottom row first
+    bool topDown{};
+
+    bool compressed() const { return this->format == 0; }
+};
+
+/**
+ * Reads a KTX 1.1 file holding a single 2D texture in one of the formats of formatInfo(),
+ * failureReason is set when it returns false.
+ */
+bool parseKtx(std::span<const unsigned char> bytes, CookedTexture &texture, const char *&failureReason);
+
+/**
+ * Reads a DDS file holding a single 2D texture: DXT1/3/5, ATI1/2 (BC4/5), 32 bit RGBA/BGRA, or any
+ * of those and BC7 through a DX10 header.
+ */
+bool parseDds(std::span<const unsigned char> bytes, CookedTexture &texture, const char *&failureReason);
+
+// Picks the parser from the file's magic number
+bool parseTextureFile(std::span<const unsigned char> bytes, CookedTexture &texture, const char *&failureReason);
+
+
+#endif //OPENGL_TEST_TEXTUREFILE_H
@@ -0,0 +1,262 @@
+#include "TextureLoader.h"
+
+#include "SDL3/SDL.h"
+
+#include "glbinding/gl/gl.h"
+
+#include "glbinding-aux/ContextInfo.h"
+
+#include "BlockCompression.h"
+
+#include "../vendored/stb_image.h"
+
+using namespace std;
+using namespace gl;
+using namespace glbinding;
+
+// "./textures/container.jpg" -> "./textures/container.ktx"
+static string cookedPathOf(const string &path) {
+    const size_t slash = path.find_last_of('/');
+    const size_t dot = path.find_last_of('.');
+    if (dot == string::npos || (slash != string::npos && dot < slash)) {
+        return path + ".ktx";
+    }
+    return path.substr(0, dot) + ".ktx";
+}
+
+static bool isTextureFile(const string &path) {
+    return path.ends_with(".ktx") || path.ends_with(".dds");
+}
+
+void TextureLoader::init(JobSystem &jobs) {
+    this->jobs = &jobs;
+    this->mipGenerator.jobs = &jobs;
+
+    // The flag is global in stb_image, so it must be set before any job starts decoding
+    stbi_set_flip_vertically_on_load(true);
+    this->queryCapabilities();
+    if (this->cpuMipmaps) {
+        SDL_Log("Texture loader: generating mipmaps on the CPU (%s filter, %s)",
+                mipFilterName(this->mipGenerator.filter), MipGenerator::instructionSet());
+    }
+
+    glGenTextures(1, &this->placeholder);
+    glBindTexture(GL_TEXTURE_2D, this->placeholder);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholderPixels);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    this->uploader.init();
+}
+
+void TextureLoader::load(const char *path, unsigned int *target) {
+    *target = this->placeholder;
+
+    {
+        lock_guard lock(this->mutex);
+        this->inFlight++;
+    }
+
+    // Jobs must be copyable, so the image (which may own a file) is only created in the job
+    this->jobs->run([this, target, imagePath = string(path)]() mutable {
+        DecodedImage image;
+        image.target = target;
+        image.path = std::move(imagePath);
+        if (isTextureFile(image.path)) {
+            if (AssetData source; not Assets::read(image.path, source)) {
+                image.failureReason = "file not found";
+            } else {
+                this->loadTextureFile(image, std::move(source));
+            }
+            lock_guard lock(this->mutex);
+            this->decoded.push_back(std::move(image));
+            return;
+        }
+
+        // An image cooked by texture_cooker replaces its source
+        const string cookedPath = cookedPathOf(image.path);
+        if (AssetData source; Assets::read(cookedPath, source)) {
+            if (this->loadTextureFile(image, std::move(source))) {
+                lock_guard lock(this->mutex);
+                this->decoded.push_back(std::move(image));
+                return;
+            }
+            SDL_LogError(0, "Texture loader error: Ignoring %s (%s)", cookedPath.c_str(), image.failureReason);
+            image.failureReason = nullptr;
+        }
+
+        if (AssetData asset; Assets::read(image.path, asset)) {
+            // The mip generator works on RGBA, otherwise the image keeps its own channels
+            image.pixels = stbi_load_from_memory(asset.bytes.data(), static_cast<int>(asset.bytes.size()),
+                                                 &image.width, &image.height, &image.channels, this->cpuMipmaps ? 4 : 0);
+        } else {
+            image.failureReason = "file not found";
+        }
+        if (not image.pixels && not image.failureReason) {
+            // The failure reason is thread local, so we grab it here
+            image.failureReason = stbi_failure_reason();
+        }
+        if (image.pixels && this->cpuMipmaps) {
+            this->generateMipmaps(image);
+        }
+
+        lock_guard lock(this->mutex);
+        this->decoded.push_back(std::move(image));
+    }, &this->decodeJobs);
+}
+
+void TextureLoader::loadAtlas(GLStateCache &state, TextureAtlas &atlas, const span<const char *const> paths) {
+    vector<AtlasImage> images(paths.size());
+    JobCounter atlasJobs;
+    for (size_t i = 0; i < paths.size(); i++) {
+        images[i].name = paths[i];
+        this->jobs->run([&image = images[i]] {
+            AssetData asset;
+            if (not Assets::read(image.name, asset)) {
+                SDL_LogError(0, "Texture loader error: Failed to load %s (file not found)", image.name.c_str());
+                return;
+            }
+            int channels = 0;
+            unsigned char *pixels = stbi_load_from_memory(asset.bytes.data(), static_cast<int>(asset.bytes.size()),
+                                                          &image.width, &image.height, &channels, 4);
+            if (not pixels) {
+                SDL_LogError(0, "Texture loader error: Failed to load %s (%s)", image.name.c_str(), stbi_failure_reason());
+                return;
+            }
+            image.pixels.assign(pixels, pixels + static_cast<size_t>(image.width) * image.height * 4);
+            stbi_image_free(pixels);
+        }, &atlasJobs);
+    }
+    this->jobs->wait(atlasJobs);
+
+    atlas.build(state, images);
+}
+
+void TextureLoader::update(GLStateCache &state) {
+    vector<DecodedImage> ready;
+    {
+        lock_guard lock(this->mutex);
+        ready.swap(this->decoded);
+        this->inFlight -= ready.size();
+    }
+
+    for (auto &image: ready) {
+        if (not image.cooked.levels.empty()) {
+            this->uploader.enqueue(state, {
+                .name = std::move(image.path),
+                .target = image.target,
+                .width = image.cooked.width,
+                .height = image.cooked.height,
+                .source = std::move(image.source),
+                .cooked = std::move(image.cooked),
+            });
+            continue;
+        }
+        if (not image.pixels) {
+            SDL_LogError(0, "Texture loader error: Failed to load %s (%s)", image.path.c_str(), image.failureReason);
+            continue;
+        }
+
+        this->uploader.enqueue(state, {
+            .name = std::move(image.path),
+            .target = image.target,
+            .width = image.width,
+            .height = image.height,
+            .channels = image.channels,
+            .pixels = image.pixels,
+            .release = stbi_image_free,
+        });
+    }
+
+    this->uploader.update(state);
+}
+
+void TextureLoader::queryCapabilities() {
+    const auto extensions = aux::ContextInfo::extensions();
+    const Version version = aux::ContextInfo::version();
+
+    auto &capabilities = this->capabilities;
+    capabilities.s3tc = extensions.contains(GLextension::GL_EXT_texture_compression_s3tc);
+    capabilities.s3tcSrgb = capabilities.s3tc && (extensions.contains(GLextension::GL_EXT_texture_sRGB)
+                                                  || extensions.contains(GLextension::GL_EXT_texture_compression_s3tc_srgb));
+    capabilities.bptc = version >= Version(4, 2) || extensions.contains(GLextension::GL_ARB_texture_compression_bptc);
+    capabilities.etc2 = version >= Version(4, 3) || extensions.contains(GLextension::GL_ARB_ES3_compatibility);
+
+    SDL_Log("Texture loader: compressed formats: S3TC %s, S3TC sRGB %s, RGTC yes, BPTC %s, ETC2 %s",
+            capabilities.s3tc ? "yes" : "no", capabilities.s3tcSrgb ? "yes" : "no",
+            capabilities.bptc ? "yes" : "no", capabilities.etc2 ? "yes" : "no");
+}
+
+bool TextureLoader::loadTextureFile(DecodedImage &image, AssetData source) const {
+    if (not parseTextureFile(source.bytes, image.cooked, image.failureReason)) {
+        image.cooked = {};
+        return false;
+    }
+
+    if (not this->capabilities.supports(image.cooked.internalFormat)) {
+        CookedTexture decoded;
+        vector<unsigned char> pixels;
+        if (not decompress(image.cooked, source.bytes, decoded, pixels)) {
+            image.failureReason = "the driver doesn't support its format, which can't be decoded on the CPU";
+            image.cooked = {};
+            return false;
+        }
+        SDL_Log("Texture loader: %s is not supported by the driver, decoded %s on the CPU",
+                formatInfo(image.cooked.internalFormat)->name, image.path.c_str());
+        image.cooked = std::move(decoded);
+        source.storage = std::move(pixels);
+        source.bytes = source.storage;
+    }
+
+    if (image.cooked.topDown) {
+        // Assets read from the pack or the executable are read-only, so those are flipped in a copy
+        if (source.bytes.data() != source.storage.data()) {
+            source.storage.assign(source.bytes.begin(), source.bytes.end());
+            source.bytes = source.storage;
+        }
+        if (not flipVertically(image.cooked, source.storage, image.failureReason)) {
+            image.cooked = {};
+            return false;
+        }
+    }
+
+    image.source = std::move(source);
+    return true;
+}
+
+void TextureLoader::generateMipmaps(DecodedImage &image) const {
+    auto &cooked = image.cooked;
+    cooked.internalFormat = formatRgba8;
+    cooked.format = pixelFormatRgba;
+    cooked.type = pixelTypeUnsignedByte;
+    cooked.width = image.width;
+    cooked.height = image.height;
+    this->mipGenerator.generate(image.pixels, image.width, image.height, image.source.storage, cooked.levels);
+    image.source.bytes = image.source.storage;
+
+    stbi_image_free(image.pixels);
+    image.pixels = nullptr;
+}
+
+bool TextureLoader::busy() {
+    lock_guard lock(this->mutex);
+    return this->inFlight != 0 || this->uploader.busy();
+}
+
+void TextureLoader::shutdown() {
+    // The jobs write into decoded, so they must all be done before we free it
+    if (this->jobs) {
+        this->jobs->wait(this->decodeJobs);
+    }
+
+    for (const auto &image: this->decoded) {
+        stbi_image_free(image.pixels);
+    }
+    this->decoded.clear();
+    this->inFlight = 0;
+
+    this->uploader.shutdown();
+    if (this->placeholder) {
+        glDeleteTextures(1, &this->placeholder);
+        this->placeholder = 0;
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#ifndef OPENGL_TEST_TEXTURELOADER_H
+#define OPENGL_TEST_TEXTURELOADER_H
+
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Assets.h"
+#include "JobSystem.h"
+#include "MipGenerator.h"
+#include "TextureAtlas.h"
+#include "TextureFile.h"
+#include "TextureUploader.h"
+
+struct DecodedImage {
+    unsigned int *target{};
+    std::string path;
+    int width{};
+    int height{};
+    int channels{};
+    // Owned by stb_image, null when decoding failed or when the image was cooked
+    unsigned char *pixels{};
+    const char *failureReason{};
+    // The cooked file and its levels, when there was one the GPU can use
+    AssetData source{};
+    CookedTexture cooked{};
+};
+
+/**
+ * Decodes images with stb_image as JobSystem jobs, then streams them to the GPU
+ * with a TextureUploader on the GL thread.
+ *
+ * KTX and DDS files have their levels uploaded as they are, without decoding anything or generating mipmaps.
+ * An image cooked by texture_cooker (same path with a .ktx extension) is used instead of its source when
+ * it exists. Compressed formats the driver lacks are decoded on the CPU (S3TC only, see BlockCompression.h),
+ * and a cooked file that can't be used falls back to decoding the source image.
+ *
+ * With cpuMipmaps, decoded images get their mip chain from mipGenerator in the decode job, and are
+ * uploaded level by level like cooked files, instead of through glGenerateMipmap on the GL thread.
+ *
+ * load() points the target texture at a shared placeholder checkerboard right away, and
+ * update() points it at the real texture once it is fully uploaded. Callers can bind the
+ * texture immediately and never have to know whether it finished loading.
+ */
+class TextureLoader {
+public:
+    JobSystem *jobs{};
+    // Counts the decode jobs still running
+    JobCounter decodeJobs;
+    std::mutex mutex;
+    std::vector<DecodedImage> decoded;
+    size_t inFlight{};
+    unsigned int placeholder{};
+    TextureUploader uploader;
+    // Compressed formats the driver can sample, the others are decoded on the CPU when possible
+    TextureCapabilities capabilities;
+    // Generate the mipmaps of decoded images on the CPU, with --cpu-mipmaps
+    bool cpuMipmaps = false;
+    MipGenerator mipGenerator;
+
+    // Needs a current context for the placeholder uploads
+    void init(JobSystem &jobs);
+
+    // Sets target to the placeholder, then to the texture of path once it is loaded
+    void load(const char *path, unsigned int *target);
+
+    /**
+     * Decodes every image as jobs and packs them into atlas. Unlike load() this waits for them,
+     * the atlas is built once at startup and its regions must not move afterwards.
+     */
+    void loadAtlas(GLStateCache &state, TextureAtlas &atlas, std::span<const char *const> paths);
+
+    // Streams the decoded images to the GPU, must run on the GL thread once per frame
+    void update(GLStateCache &state);
+
+    // True while some textures still show the placeholder
+    bool busy();
+
+    void shutdown();
+
+private:
+    void queryCapabilities();
+
+    // Runs in a decode job, false (with image.failureReason set) when the file is invalid or the driver can't use it
+    bool loadTextureFile(DecodedImage &image, AssetData source) const;
+
+    // Runs in a decode job, turns the decoded pixels into an RGBA8 mip chain
+    void generateMipmaps(DecodedImage &image) const;
+};
+
+
+#endif //OPENGL_TEST_TEXTURELOADER_H
@@ -0,0 +1,273 @@
+#include "TextureUploader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "SDL3/SDL.h"
+
+#include "glbinding/gl33core/gl.h"
+
+using namespace std;
+using namespace gl33core;
+
+static GLenum formatOf(const int channels) {
+    switch (channels) {
+        case 1: return GL_RED;
+        case 2: return GL_RG;
+        case 3: return GL_RGB;
+        default: return GL_RGBA;
+    }
+}
+
+void TextureUploader::init(const size_t bufferSize, const size_t frameBudget) {
+    this->bufferSize = bufferSize;
+    this->frameBudget = frameBudget;
+
+    glGenBuffers(ringSize, this->buffers.data());
+    for (const unsigned int buffer: this->buffers) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(bufferSize), nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void TextureUploader::enqueue(GLStateCache &state, TextureUpload upload) {
+    // Texture storage is allocated now, the rows follow over the next frames
+    glGenTextures(1, &upload.texture);
+    state.bindTexture(0, TextureTarget::Texture2D, upload.texture);
+
+    if (upload.isCooked()) {
+        const CookedTexture &cooked = upload.cooked;
+        for (size_t level = 0; level < cooked.levels.size(); level++) {
+            const TextureLevel &image = cooked.levels[level];
+            if (cooked.compressed()) {
+                glCompressedTexImage2D(
+                    GL_TEXTURE_2D, static_cast<GLint>(level), static_cast<GLenum>(cooked.internalFormat),
+                    image.width, image.height, 0, static_cast<GLsizei>(image.size), nullptr
+                );
+            } else {
+                glTexImage2D(
+                    GL_TEXTURE_2D, static_cast<GLint>(level), static_cast<GLint>(cooked.internalFormat),
+                    image.width, image.height, 0, static_cast<GLenum>(cooked.format), static_cast<GLenum>(cooked.type), nullptr
+                );
+            }
+        }
+        // Files with only the base level are still complete textures
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(cooked.levels.size() - 1));
+    } else {
+        const GLenum format = formatOf(upload.channels);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, upload.width, upload.height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    upload.nextRow = 0;
+    upload.nextLevel = 0;
+    this->pending.push_back(std::move(upload));
+}
+
+bool TextureUploader::uploadBands(
+    GLStateCache &state, const int level, const TextureLevel &image, const unsigned int format, const unsigned int type,
+    const unsigned char *pixels, int &nextRow, size_t &budget
+) {
+    const size_t rowSize = image.size / image.height;
+
+    if (rowSize > this->bufferSize) {
+        // A single row doesn't fit in a PBO, we fall back to a plain synchronous upload
+        glTexSubImage2D(
+            GL_TEXTURE_2D, level, 0, 0, image.width, image.height,
+            static_cast<GLenum>(format), static_cast<GLenum>(type), pixels
+        );
+        this->bytesLastFrame += image.size;
+        this->bytesTotal += image.size;
+        budget -= min(budget, image.size);
+        nextRow = image.height;
+        return true;
+    }
+
+    while (nextRow < image.height && budget > 0) {
+        const size_t rowsLeft = image.height - nextRow;
+        const size_t rowsFitting = this->bufferSize / rowSize;
+        const size_t rowsInBudget = max<size_t>(budget / rowSize, 1);
+        const size_t rows = min({rowsLeft, rowsFitting, rowsInBudget});
+        const size_t bytes = rows * rowSize;
+
+        if (not this->fillBuffer(state, pixels + nextRow * rowSize, bytes)) {
+            return false;
+        }
+        // With a PBO bound, the pointer argument is an offset into the buffer
+        glTexSubImage2D(
+            GL_TEXTURE_2D, level, 0, nextRow, image.width, static_cast<GLsizei>(rows),
+            static_cast<GLenum>(format), static_cast<GLenum>(type), nullptr
+        );
+        this->submitBuffer(state, bytes);
+
+        nextRow += static_cast<int>(rows);
+        budget -= min(budget, bytes);
+    }
+    return true;
+}
+
+bool TextureUploader::uploadRows(GLStateCache &state, TextureUpload &upload, size_t &budget) {
+    state.bindTexture(0, TextureTarget::Texture2D, upload.texture);
+
+    const size_t rowSize = static_cast<size_t>(upload.width) * upload.channels;
+    const TextureLevel image{upload.width, upload.height, 0, rowSize * upload.height};
+    return this->uploadBands(
+        state, 0, image, static_cast<unsigned int>(formatOf(upload.channels)), static_cast<unsigned int>(GL_UNSIGNED_BYTE),
+        upload.pixels, upload.nextRow, budget
+    );
+}
+
+bool TextureUploader::uploadLevels(GLStateCache &state, TextureUpload &upload, size_t &budget) {
+    const CookedTexture &cooked = upload.cooked;
+    state.bindTexture(0, TextureTarget::Texture2D, upload.texture);
+
+    while (upload.nextLevel < cooked.levels.size() && budget > 0) {
+        const auto level = static_cast<GLint>(upload.nextLevel);
+        const TextureLevel &image = cooked.levels[upload.nextLevel];
+        const unsigned char *data = upload.source.bytes.data() + image.offset;
+
+        // Uncompressed levels go out in row bands like decoded images, nextRow being the row within the level
+        if (not cooked.compressed()) {
+            if (not this->uploadBands(state, level, image, cooked.format, cooked.type, data, upload.nextRow, budget)) {
+                return false;
+            }
+            if (upload.nextRow < image.height) {
+                return true;
+            }
+            upload.nextRow = 0;
+            upload.nextLevel++;
+            continue;
+        }
+
+        // Compressed levels can't be split by rows, one that doesn't fit in a PBO is uploaded synchronously
+        const bool direct = image.size > this->bufferSize;
+        if (not direct && not this->fillBuffer(state, data, image.size)) {
+            return false;
+        }
+        glCompressedTexSubImage2D(
+            GL_TEXTURE_2D, level, 0, 0, image.width, image.height,
+            static_cast<GLenum>(cooked.internalFormat), static_cast<GLsizei>(image.size), direct ? data : nullptr
+        );
+
+        if (direct) {
+            this->bytesLastFrame += image.size;
+            this->bytesTotal += image.size;
+        } else {
+            this->submitBuffer(state, image.size);
+        }
+        upload.nextLevel++;
+        budget -= min(budget, image.size);
+    }
+    return true;
+}
+
+bool TextureUploader::fillBuffer(GLStateCache &state, const unsigned char *data, const size_t size) {
+    const size_t slot = this->nextBuffer;
+    if (const auto fence = static_cast<GLsync>(this->fences[slot])) {
+        // Don't wait: if the GPU still reads from this PBO we try again next frame
+        if (glClientWaitSync(fence, GL_NONE_BIT, 0) == GL_TIMEOUT_EXPIRED) {
+            return false;
+        }
+        glDeleteSync(fence);
+        this->fences[slot] = nullptr;
+    }
+
+    state.bindBuffer(BufferTarget::PixelUnpack, this->buffers[slot]);
+    // The fence told us the GPU is done with this buffer, so no need for the driver to synchronize
+    void *mapped = glMapBufferRange(
+        GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size),
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+    );
+    if (not mapped) {
+        state.bindBuffer(BufferTarget::PixelUnpack, 0);
+        return false;
+    }
+    memcpy(mapped, data, size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    return true;
+}
+
+void TextureUploader::submitBuffer(GLStateCache &state, const size_t size) {
+    // Left bound, any other unpack would read from the PBO
+    state.bindBuffer(BufferTarget::PixelUnpack, 0);
+
+    this->fences[this->nextBuffer] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT);
+    this->nextBuffer = (this->nextBuffer + 1) % ringSize;
+
+    this->bytesLastFrame += size;
+    this->bytesTotal += size;
+}
+
+void TextureUploader::finish(GLStateCache &state, TextureUpload &upload) {
+    *upload.target = upload.texture;
+
+    if (upload.isCooked()) {
+        const TextureFormatInfo *info = formatInfo(upload.cooked.internalFormat);
+        SDL_Log("Texture uploader: uploaded %s (%ix%i %s, %zu levels)", upload.name.c_str(), upload.width, upload.height,
+                info ? info->name : "unknown format", upload.cooked.levels.size());
+        upload.source = {};
+        return;
+    }
+
+    state.bindTexture(0, TextureTarget::Texture2D, upload.texture);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    if (upload.release) {
+        upload.release(upload.pixels);
+    }
+    upload.pixels = nullptr;
+
+    SDL_Log("Texture uploader: uploaded %s (%ix%i, %i channels)", upload.name.c_str(), upload.width, upload.height, upload.channels);
+}
+
+void TextureUploader::update(GLStateCache &state) {
+    this->bytesLastFrame = 0;
+    if (this->pending.empty()) {
+        return;
+    }
+
+    // Rows are tightly packed, whatever their size
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    size_t budget = this->frameBudget;
+    while (not this->pending.empty() && budget > 0) {
+        auto &upload = this->pending.front();
+        if (upload.isCooked()) {
+            if (not this->uploadLevels(state, upload, budget) || upload.nextLevel < upload.cooked.levels.size()) {
+                break;
+            }
+        } else if (not this->uploadRows(state, upload, budget) || upload.nextRow < upload.height) {
+            break;
+        }
+
+        this->finish(state, upload);
+        this->pending.pop_front();
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+bool TextureUploader::busy() const {
+    return not this->pending.empty();
+}
+
+void TextureUploader::shutdown() {
+    for (auto &upload: this->pending) {
+        if (upload.release) {
+            upload.release(upload.pixels);
+        }
+        glDeleteTextures(1, &upload.texture);
+    }
+    this->pending.clear();
+
+    for (auto &fence: this->fences) {
+        if (fence) {
+            glDeleteSync(static_cast<GLsync>(fence));
+            fence = nullptr;
+        }
+    }
+    if (this->buffers[0]) {
+        glDeleteBuffers(ringSize, this->buffers.data());
+        this->buffers.fill(0);
+    }
+}
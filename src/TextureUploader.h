@@ -0,0 +1,97 @@
+#pragma once
+
+#ifndef OPENGL_TEST_TEXTUREUPLOADER_H
+#define OPENGL_TEST_TEXTUREUPLOADER_H
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <string>
+
+#include "Assets.h"
+#include "GLStateCache.h"
+#include "TextureFile.h"
+
+struct TextureUpload {
+    std::string name;
+    // Receives the texture name once every level is uploaded
+    unsigned int *target{};
+    int width{};
+    int height{};
+    int channels{};
+    unsigned char *pixels{};
+    // Frees pixels once they have been copied
+    void (*release)(void *){};
+
+    // Cooked textures have their mip chain in source instead of pixels, uploaded a level at a time
+    AssetData source{};
+    CookedTexture cooked{};
+
+    // Filled by the uploader
+    unsigned int texture{};
+    // Within nextLevel for cooked textures
+    int nextRow{};
+    size_t nextLevel{};
+
+    bool isCooked() const { return not this->cooked.levels.empty(); }
+};
+
+/**
+ * Streams texture data to the GPU through a ring of pixel buffer objects.
+ *
+ * Each frame, update() copies rows of the pending textures into PBOs that the GPU is done with
+ * (checked with fences, so it never waits) and issues glTexSubImage2D from them, so the transfers
+ * overlap with rendering. At most frameBudget bytes go out per frame: a large texture is spread
+ * over several frames instead of causing a hitch when it lands.
+ *
+ * Cooked textures already have every mip level in their GPU format and skip glGenerateMipmap. Their
+ * uncompressed levels go out in row bands too, compressed ones a whole level at a time.
+ */
+class TextureUploader {
+public:
+    static constexpr size_t ringSize = 8;
+
+    std::array<unsigned int, ringSize> buffers{};
+    // GLsync objects, kept opaque so that GL headers don't leak out
+    std::array<void *, ringSize> fences{};
+    size_t nextBuffer{};
+    size_t bufferSize{};
+    size_t frameBudget{};
+    std::deque<TextureUpload> pending;
+
+    // Statistics
+    size_t bytesLastFrame{};
+    size_t bytesTotal{};
+
+    void init(size_t bufferSize = 1 << 20, size_t frameBudget = 4 << 20);
+
+    void enqueue(GLStateCache &state, TextureUpload upload);
+
+    // Uploads up to frameBudget bytes, must run on the GL thread once per frame
+    void update(GLStateCache &state);
+
+    bool busy() const;
+
+    void shutdown();
+
+private:
+    // Copies rows of one level from nextRow on, through as many PBOs as needed, false while it waits for one
+    bool uploadBands(GLStateCache &state, int level, const TextureLevel &image, unsigned int format, unsigned int type,
+                     const unsigned char *pixels, int &nextRow, size_t &budget);
+
+    // Returns false when the data has to wait for a PBO the GPU still uses
+    bool uploadRows(GLStateCache &state, TextureUpload &upload, size_t &budget);
+
+    bool uploadLevels(GLStateCache &state, TextureUpload &upload, size_t &budget);
+
+    // Copies data into the next PBO of the ring and leaves it bound, false while the GPU still reads from it
+    bool fillBuffer(GLStateCache &state, const unsigned char *data, size_t size);
+
+    // Unbinds the PBO filled last and fences it once the uploads reading from it are issued
+    void submitBuffer(GLStateCache &state, size_t size);
+
+    void finish(GLStateCache &state, TextureUpload &upload);
+};
+
+
+#endif //OPENGL_TEST_TEXTUREUPLOADER_H
@@ -0,0 +1,63 @@
+#pragma once
+
+#ifndef OPENGL_TEST_TRIPLEBUFFER_H
+#define OPENGL_TEST_TRIPLEBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Lock-free mailbox between exactly one producer thread and one consumer thread.
+ *
+ * The producer fills writeBuffer() and publishes it, the consumer picks up the most recent
+ * published buffer with consume(). Neither side ever waits for the other: a producer running
+ * ahead overwrites the unconsumed buffer, a consumer running ahead keeps the buffer it has.
+ */
+template<typename T>
+class TripleBuffer {
+public:
+    std::array<T, 3> buffers{};
+
+    T &writeBuffer() {
+        return this->buffers[this->writeIndex];
+    }
+
+    const T &readBuffer() const {
+        return this->buffers[this->readIndex];
+    }
+
+    // Index of the buffer being written, stays the same until the next publish()
+    uint8_t writeSlot() const {
+        return this->writeIndex;
+    }
+
+    // Hands the write buffer over to the consumer and takes back the buffer it didn't pick up
+    void publish() {
+        const uint8_t previous = this->shared.exchange(this->writeIndex | freshBit, std::memory_order_acq_rel);
+        this->writeIndex = previous & indexMask;
+    }
+
+    // Switches to the most recently published buffer, returns false if nothing new was published
+    bool consume() {
+        if ((this->shared.load(std::memory_order_relaxed) & freshBit) == 0) {
+            return false;
+        }
+        const uint8_t previous = this->shared.exchange(this->readIndex, std::memory_order_acq_rel);
+        this->readIndex = previous & indexMask;
+        return true;
+    }
+
+private:
+    static constexpr uint8_t indexMask = 0b11;
+    // Set on the shared index when it holds a buffer the consumer hasn't seen
+    static constexpr uint8_t freshBit = 0b100;
+
+    // Each index is only touched by one side, the shared one is swapped atomically
+    uint8_t writeIndex = 0;
+    std::atomic<uint8_t> shared = 1;
+    uint8_t readIndex = 2;
+};
+
+
+#endif //OPENGL_TEST_TRIPLEBUFFER_H
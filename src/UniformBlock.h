@@ -0,0 +1,87 @@
+#pragma once
+
+#ifndef OPENGL_TEST_UNIFORMBLOCK_H
+#define OPENGL_TEST_UNIFORMBLOCK_H
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+#include "GLStateCache.h"
+#include "Std140.h"
+#include "StreamBuffer.h"
+
+// Fixed binding points, every program sees the same block at the same binding
+enum class UniformBinding : unsigned int {
+    Frame = 0,
+    View = 1,
+};
+
+// Per frame values, "FrameBlock" in the shaders
+struct alignas(16) FrameBlock {
+    // Drawable size in pixels
+    std140::vec2 resolution;
+    // Seconds since startup
+    std140::float_ time;
+    std140::float_ deltaTime;
+    std140::uint frameNumber;
+};
+
+constexpr std::array frameBlockMembers = {
+    STD140_MEMBER(FrameBlock, resolution),
+    STD140_MEMBER(FrameBlock, time),
+    STD140_MEMBER(FrameBlock, deltaTime),
+    STD140_MEMBER(FrameBlock, frameNumber),
+};
+
+static_assert(std140::isBlock<FrameBlock>);
+static_assert(std140::matches<FrameBlock>(frameBlockMembers), "FrameBlock doesn't follow std140, or frameBlockMembers misses a member");
+
+// Camera values, "ViewBlock" in the shaders
+struct alignas(16) ViewBlock {
+    std140::mat4 viewProjection = std140::mat4::identity();
+};
+
+constexpr std::array viewBlockMembers = {
+    STD140_MEMBER(ViewBlock, viewProjection),
+};
+
+static_assert(std140::isBlock<ViewBlock>);
+static_assert(std140::matches<ViewBlock>(viewBlockMembers), "ViewBlock doesn't follow std140, or viewBlockMembers misses a member");
+
+struct UniformBlockInfo {
+    std::string_view name;
+    UniformBinding binding;
+    // std140 size before the padding to a vec4, drivers report this or the padded size
+    size_t size;
+};
+
+// Shader binds each block it finds in a program to its binding point, and checks its size against the struct's
+constexpr std::array<UniformBlockInfo, 2> uniformBlocks = {{
+    {"FrameBlock", UniformBinding::Frame, std140::layout(frameBlockMembers).size},
+    {"ViewBlock", UniformBinding::View, std140::layout(viewBlockMembers).size},
+}};
+
+/**
+ * CPU copy of a uniform block. upload() writes it to the stream buffer and binds that range to the
+ * block's binding point: one write replaces the glUniform calls of every program using the block.
+ */
+template<typename T>
+class UniformBlock {
+    static_assert(std140::isBlock<T>, "Uniform blocks must follow the std140 layout");
+
+public:
+    T data{};
+    UniformBinding binding{};
+
+    explicit UniformBlock(const UniformBinding binding) : binding(binding) {
+    }
+
+    void upload(GLStateCache &state, StreamBuffer &stream) const {
+        const auto allocation = stream.write(&this->data, sizeof(T));
+        state.bindUniformBuffer(static_cast<unsigned int>(this->binding), allocation.buffer, allocation.offset, sizeof(T));
+    }
+};
+
+
+#endif //OPENGL_TEST_UNIFORMBLOCK_H
@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <string_view>
 
 #include "SDL3/SDL.h"
 #include "SDL3/SDL_main.h"
@@ -14,6 +18,7 @@
 #include "glbinding-aux/debug.h"
 
 #include "AppContext.h"
+#include "Assets.h"
 #include "RenderEngine.h"
 #include "helperFunctions.h"
 
@@ -24,15 +29,224 @@ using namespace glbinding;
 constexpr uint32_t windowStartWidth = 800;
 constexpr uint32_t windowStartHeight = 600;
 
-bool wireframe = false;
+// Rate of SDL_AppIterate when the render thread is presenting frames on its own
+constexpr const char *simulationRate = "120";
+
+constexpr const char *assetPackPath = "./assets.pack";
+
+// Starting size of each frame arena region, they grow when a frame needs more
+constexpr size_t frameArenaCapacity = 256 * 1024;
+
+void printUsage(const char *program) {
+    SDL_Log("Usage: %s [--headless] [--frames N] [--bench N] [--bench-json FILE] [--no-shader-cache] [--sprites N] [--single-thread] [--watch-shaders] [--cpu-mipmaps box|kaiser]", program);
+    SDL_Log("  --headless         Render offscreen through EGL, no window is created");
+    SDL_Log("  --frames N         Quit after rendering N frames");
+    SDL_Log("  --bench N          Time N frames with VSync off, then print a report and quit");
+    SDL_Log("  --bench-json FILE  Write the benchmark JSON report to FILE instead of stdout");
+    SDL_Log("  --no-shader-cache  Always compile shaders from source");
+    SDL_Log("  --sprites N        Draw N animated sprites with one instanced draw call");
+    SDL_Log("  --single-thread    Render from the main thread instead of a dedicated render thread");
+    SDL_Log("  --watch-shaders    Rebuild the shaders when their sources change");
+    SDL_Log("  --cpu-mipmaps F    Generate texture mipmaps on worker threads with the box or kaiser filter");
+}
+
+bool parseArguments(const int argc, char *argv[], LaunchOptions &options) {
+    for (int i = 1; i < argc; i++) {
+        const string_view argument = argv[i];
+
+        if (argument == "--headless") {
+            options.backend = RenderBackend::Headless;
+        } else if (argument == "--frames" && i + 1 < argc) {
+            options.frameLimit = strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--bench" && i + 1 < argc) {
+            options.benchmarkFrames = strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--bench-json" && i + 1 < argc) {
+            options.benchmarkJsonPath = argv[++i];
+        } else if (argument == "--no-shader-cache") {
+            options.programCache = false;
+        } else if (argument == "--sprites" && i + 1 < argc) {
+            options.spriteCount = strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--single-thread") {
+            options.renderThread = false;
+        } else if (argument == "--watch-shaders") {
+            options.watchShaders = true;
+        } else if (argument == "--cpu-mipmaps" && i + 1 < argc) {
+            const string_view filter = argv[++i];
+            if (filter != "box" && filter != "kaiser") {
+                SDL_LogError(0, "Unknown mipmap filter: %s", argv[i]);
+                printUsage(argv[0]);
+                return false;
+            }
+            options.cpuMipmaps = true;
+            options.mipFilter = filter == "kaiser" ? MipFilter::Kaiser : MipFilter::Box;
+        } else {
+            SDL_LogError(0, "Unknown argument: %s", argv[i]);
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Lays the sprites out on a grid covering the screen, cycling through the images of the sprite atlas
+ */
+void createSprites(AppContext *app) {
+    const size_t count = app->options.spriteCount;
+    const auto &regions = app->renderer.spriteAtlas.regions;
+    const auto columns = static_cast<size_t>(ceil(sqrt(static_cast<double>(count))));
+    const float cellSize = 2.0f / static_cast<float>(columns);
+
+    app->sprites.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        auto &sprite = app->sprites[i];
+        sprite.position[0] = -1.0f + cellSize * (static_cast<float>(i % columns) + 0.5f);
+        sprite.position[1] = -1.0f + cellSize * (static_cast<float>(i / columns) + 0.5f);
+        sprite.scale[0] = sprite.scale[1] = cellSize * 0.8f;
+        sprite.tint[0] = static_cast<float>(i % 7) / 6.0f;
+        sprite.tint[1] = static_cast<float>(i % 5) / 4.0f;
+        sprite.tint[2] = static_cast<float>(i % 3) / 2.0f;
+        sprite.tint[3] = 0.8f;
+
+        const AtlasRegion &region = regions.empty() ? app->renderer.spriteAtlas.placeholder : regions[i % regions.size()];
+        ranges::copy(region.uvRect, sprite.uvRect);
+        sprite.layer = region.layer;
+    }
+}
+
+void updateSprites(AppContext *app) {
+    const auto seconds = static_cast<float>(SDL_GetTicks()) / 1000.0f;
+    for (size_t i = 0; i < app->sprites.size(); i++) {
+        app->sprites[i].rotation = seconds + static_cast<float>(i) * 0.1f;
+    }
+}
+
+/**
+ * Copies the simulation state into the next snapshot and hands it to the renderer
+ */
+void publishFrame(AppContext *app) {
+    FrameSnapshot &frame = app->frames.writeBuffer();
+    frame.frameNumber = app->simulationFrame++;
+    frame.time = static_cast<float>(SDL_GetTicks()) / 1000.0f;
+    frame.wireframe = app->wireframe;
+    if (app->renderer.window) {
+        SDL_GetWindowSizeInPixels(app->renderer.window, &frame.width, &frame.height);
+    }
+    const auto sprites = app->frameArena.allocateArray<SpriteInstance>(app->frames.writeSlot(), app->sprites.size());
+    ranges::copy(app->sprites, sprites.begin());
+    frame.sprites = sprites;
+
+    app->frames.publish();
+}
+
+/**
+ * Renders one snapshot and does the per frame bookkeeping, on whichever thread owns the GL context
+ */
+SDL_AppResult renderFrame(AppContext *app, const FrameSnapshot &frame) {
+    if (const auto appResult = app->renderer.render(frame); appResult != SDL_APP_CONTINUE) {
+        return appResult;
+    }
+
+    app->frameCount++;
+
+    if (app->benchmark.active()) {
+        app->benchmark.record(app->renderer.frameTimings);
+        if (const auto &gpuTimer = app->renderer.gpuTimer; gpuTimer.hasResult) {
+            app->benchmark.recordGpu(gpuTimer.latestFrameNumber, gpuTimer.latest);
+        }
+        if (app->benchmark.finished()) {
+            const string rendererName = aux::ContextInfo::renderer();
+            return app->benchmark.report(rendererName, app->options.benchmarkJsonPath) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        }
+    }
+
+    if (app->options.frameLimit != 0 && app->frameCount >= app->options.frameLimit) {
+        SDL_Log("Rendered %llu frames, quitting", (unsigned long long) app->frameCount);
+        return SDL_APP_SUCCESS;
+    }
+    return SDL_APP_CONTINUE;
+}
+
+/**
+ * Hands the GL context over to the render thread, the main thread must not touch GL from then on
+ */
+SDL_AppResult startRendering(AppContext *app) {
+    // The renderer built the sprite atlas in init(), and doesn't touch its regions anymore
+    createSprites(app);
+    publishFrame(app);
+    app->frameArena.reset(app->frames.writeSlot());
+
+    if (not app->options.renderThread) {
+        return SDL_APP_CONTINUE;
+    }
+
+    if (not app->renderer.releaseCurrent()) {
+        return SDL_Fail();
+    }
+    SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, simulationRate);
+    app->renderThread.start(app->renderer, app->frames, [app](const FrameSnapshot &frame) {
+        return renderFrame(app, frame);
+    });
+    return SDL_APP_CONTINUE;
+}
 
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
+    // We hand the context to SDL right away so that SDL_AppQuit cleans up after a failed init
+    auto *app = new AppContext{};
+    *appstate = app;
+
+    if (not parseArguments(argc, argv, app->options)) {
+        return SDL_APP_FAILURE;
+    }
+
+    // Optional, built next to the executable by the asset_pack target. Builds with embedded assets have everything
+    // already and shouldn't touch the disk, unless shaders are being edited.
+    if (not Assets::hasEmbedded() || app->options.watchShaders) {
+        Assets::mount(assetPackPath);
+    }
+
+    app->jobs.init();
+    app->frameArena.init(frameArenaCapacity);
+
+    RenderEngine &renderer = app->renderer;
+    renderer.jobs = &app->jobs;
+    renderer.backend = app->options.backend;
+    renderer.useProgramCache = app->options.programCache;
+    renderer.watchShaders = app->options.watchShaders;
+    renderer.textureLoader.cpuMipmaps = app->options.cpuMipmaps;
+    renderer.textureLoader.mipGenerator.filter = app->options.mipFilter;
+
+    if (app->options.benchmarkFrames != 0) {
+        // We want to measure the render loop, not the display refresh rate
+        renderer.vsync = false;
+        app->benchmark.begin(app->options.benchmarkFrames);
+    }
+
+    if (renderer.backend == RenderBackend::Headless) {
+        // No video subsystem, so this works without any display server
+        if (not SDL_Init(SDL_INIT_EVENTS)) {
+            return SDL_Fail();
+        }
+
+        renderer.framebufferWidth = windowStartWidth;
+        renderer.framebufferHeight = windowStartHeight;
+
+        if (const auto appResult = renderer.init(); appResult == SDL_APP_FAILURE) {
+            return SDL_APP_FAILURE;
+        }
+
+        if (startRendering(app) == SDL_APP_FAILURE) {
+            return SDL_APP_FAILURE;
+        }
+
+        SDL_Log("Application initialized successfully!");
+        return SDL_APP_CONTINUE;
+    }
+
     if (not SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO)) {
         return SDL_Fail();
     }
 
-    RenderEngine renderer;
-
     if (const auto appResult = RenderEngine::setAttributes(); appResult == SDL_APP_FAILURE) {
         return SDL_APP_FAILURE;
     }
@@ -60,10 +274,9 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
         }
     }
 
-    *appstate = new AppContext{
-        .renderer = renderer,
-        .controlFlow = SDL_APP_CONTINUE,
-    };
+    if (startRendering(app) == SDL_APP_FAILURE) {
+        return SDL_APP_FAILURE;
+    }
 
     SDL_Log("Application initialized successfully!");
     return SDL_APP_CONTINUE;
@@ -74,13 +287,8 @@ void processInput(AppContext *app, const SDL_Event *event) {
         app->controlFlow = SDL_APP_SUCCESS;
     }
     if (event->key.key == SDLK_A && event->key.down) {
-        if (wireframe == false) {
-            wireframe = true;
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        } else {
-            wireframe = false;
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        }
+        // Sent to the renderer with the next snapshot
+        app->wireframe = not app->wireframe;
     }
 }
 
@@ -91,8 +299,6 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
         case SDL_EVENT_KEY_UP:
         case SDL_EVENT_KEY_DOWN:
             processInput(app, event);
-        case SDL_EVENT_WINDOW_RESIZED:
-            app->renderer.viewport_resize();
             break;
         case SDL_EVENT_QUIT:
             app->controlFlow = SDL_APP_SUCCESS;
@@ -104,16 +310,43 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
 }
 
 SDL_AppResult SDL_AppIterate(void *appstate) {
-    const auto *app = (AppContext *) appstate;
+    auto *app = (AppContext *) appstate;
 
-    return app->renderer.render(app);
+    updateSprites(app);
+    publishFrame(app);
+
+    SDL_AppResult appResult = app->controlFlow;
+    if (app->options.renderThread) {
+        // The render thread stops on its own when it is done (--frames, --bench) or when it failed
+        if (not app->renderThread.running) {
+            appResult = app->renderThread.result;
+        }
+    } else {
+        app->frames.consume();
+        if (const auto frameResult = renderFrame(app, app->frames.readBuffer()); frameResult != SDL_APP_CONTINUE) {
+            appResult = frameResult;
+        }
+    }
+
+    // publish() handed us back a slot the renderer let go of, so its memory can be reused
+    app->frameArena.reset(app->frames.writeSlot());
+    return appResult;
 }
 
 void SDL_AppQuit(void *appstate, SDL_AppResult result) {
-    if (const auto *app = (AppContext *) appstate) {
-        SDL_DestroyWindow(app->renderer.window);
+    if (auto *app = (AppContext *) appstate) {
+        // Take the context back from the render thread before releasing GL objects
+        if (app->renderThread.thread.joinable()) {
+            app->renderThread.stop();
+            app->renderer.makeCurrent();
+        }
+        app->renderer.shutdown();
+        app->jobs.shutdown();
+        app->frameArena.logStats();
         delete app;
     }
+    // After the texture decode jobs, which read straight from the pack
+    Assets::unmount();
 
     SDL_Log("Application quit successfully!");
     SDL_Quit();
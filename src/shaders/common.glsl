@@ -0,0 +1,11 @@
+// Uniform blocks shared by every program, see UniformBlock.h for their C++ side
+layout (std140) uniform FrameBlock {
+    vec2 resolution;
+    float time;
+    float deltaTime;
+    uint frameNumber;
+};
+
+layout (std140) uniform ViewBlock {
+    mat4 viewProjection;
+};
@@ -0,0 +1,76 @@
+#include <random>
+#include <vector>
+
+#include "AtlasPacker.h"
+#include "Check.h"
+
+static bool overlap(const AtlasRect &a, const AtlasRect &b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static void randomRects() {
+    std::mt19937 random(1);
+    for (int page = 0; page < 200; page++) {
+        SkylinePacker packer;
+        packer.init(512, 256);
+
+        std::vector<AtlasRect> placed;
+        for (int i = 0; i < 100; i++) {
+            const int width = 1 + static_cast<int>(random() % 96), height = 1 + static_cast<int>(random() % 96);
+            AtlasRect rect;
+            if (not packer.insert(width, height, rect)) {
+                continue;
+            }
+            CHECK(rect.width == width && rect.height == height);
+            CHECK(rect.x >= 0 && rect.y >= 0 && rect.x + width <= 512 && rect.y + height <= 256);
+            for (const auto &other: placed) {
+                CHECK(not overlap(rect, other));
+            }
+            placed.push_back(rect);
+        }
+        CHECK(not placed.empty());
+
+        // The skyline stays sorted, contiguous and covering the whole width
+        int x = 0;
+        for (const auto &segment: packer.skyline) {
+            CHECK(segment.x == x && segment.width > 0);
+            x += segment.width;
+        }
+        CHECK(x == 512);
+    }
+}
+
+static void fullPage() {
+    SkylinePacker packer;
+    packer.init(1024, 1024);
+    AtlasRect rect;
+    for (int i = 0; i < 16; i++) {
+        CHECK(packer.insert(256, 256, rect));
+    }
+    CHECK(not packer.insert(1, 1, rect));
+    CHECK(packer.skyline.size() == 1 && packer.skyline[0].y == 1024);
+
+    packer.init(64, 64);
+    CHECK(not packer.insert(65, 1, rect));
+    CHECK(not packer.insert(1, 65, rect));
+    CHECK(packer.insert(64, 64, rect) && rect.x == 0 && rect.y == 0);
+}
+
+static void lowestTop() {
+    // A tall then a short rectangle leave a step, the next one goes on the lower side
+    SkylinePacker packer;
+    packer.init(100, 100);
+    AtlasRect tall, shortRect, next;
+    CHECK(packer.insert(50, 60, tall));
+    CHECK(packer.insert(50, 20, shortRect));
+    CHECK(shortRect.x == 50 && shortRect.y == 0);
+    CHECK(packer.insert(40, 30, next));
+    CHECK(next.x == 50 && next.y == 20);
+}
+
+int main() {
+    randomRects();
+    fullPage();
+    lowestTop();
+    return testResult();
+}
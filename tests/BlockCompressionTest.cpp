@@ -0,0 +1,128 @@
+#include <array>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "BlockCompression.h"
+#include "Check.h"
+
+// A texture of one level made of the given blocks
+static CookedTexture blockTexture(const uint32_t internalFormat, const int width, const int height, const size_t size) {
+    CookedTexture texture;
+    texture.internalFormat = internalFormat;
+    texture.width = width;
+    texture.height = height;
+    texture.levels.push_back({width, height, 0, size});
+    return texture;
+}
+
+static std::array<unsigned char, 4> pixel(const std::vector<unsigned char> &pixels, const int width, const int x, const int y) {
+    std::array<unsigned char, 4> texel{};
+    memcpy(texel.data(), &pixels[(static_cast<size_t>(y) * width + x) * 4], 4);
+    return texel;
+}
+
+static void bc1() {
+    // Red and blue endpoints, 2 bits per texel from the lowest ones: 0, 1, 2, 3 on every row
+    const unsigned char block[8] = {0x00, 0xf8, 0x1f, 0x00, 0xe4, 0xe4, 0xe4, 0xe4};
+    CookedTexture decoded;
+    std::vector<unsigned char> pixels;
+    CHECK(decompress(blockTexture(formatBc1, 4, 4, 8), block, decoded, pixels));
+    CHECK(decoded.internalFormat == formatRgba8 && decoded.levels.size() == 1 && pixels.size() == 64);
+    CHECK((pixel(pixels, 4, 0, 0) == std::array<unsigned char, 4>{255, 0, 0, 255}));
+    CHECK((pixel(pixels, 4, 1, 3) == std::array<unsigned char, 4>{0, 0, 255, 255}));
+    CHECK((pixel(pixels, 4, 2, 1) == std::array<unsigned char, 4>{170, 0, 85, 255}));
+    CHECK((pixel(pixels, 4, 3, 2) == std::array<unsigned char, 4>{85, 0, 170, 255}));
+
+    // color0 <= color1 switches to 3 colors and black, transparent only in the alpha variant
+    const unsigned char threeColors[8] = {0x1f, 0x00, 0x00, 0xf8, 0xe4, 0xe4, 0xe4, 0xe4};
+    CHECK(decompress(blockTexture(formatBc1, 4, 4, 8), threeColors, decoded, pixels));
+    CHECK((pixel(pixels, 4, 2, 0) == std::array<unsigned char, 4>{127, 0, 127, 255}));
+    CHECK((pixel(pixels, 4, 3, 0) == std::array<unsigned char, 4>{0, 0, 0, 255}));
+    CHECK(decompress(blockTexture(formatBc1Alpha, 4, 4, 8), threeColors, decoded, pixels));
+    CHECK((pixel(pixels, 4, 3, 0) == std::array<unsigned char, 4>{0, 0, 0, 0}));
+
+    // Odd sized levels crop the blocks hanging over their edge
+    CHECK(decompress(blockTexture(formatBc1Srgb, 3, 1, 8), block, decoded, pixels));
+    CHECK(decoded.internalFormat == formatSrgb8Alpha8 && pixels.size() == 12);
+    CHECK((pixel(pixels, 3, 2, 0) == std::array<unsigned char, 4>{170, 0, 85, 255}));
+
+    CHECK(not canDecompress(formatBc7) && not canDecompress(formatBc4) && canDecompress(formatBc3Srgb));
+}
+
+static void alpha() {
+    // BC2: explicit 4 bit alpha, the color half always uses 4 colors
+    unsigned char bc2[16] = {0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0x1f, 0x00, 0x00, 0xf8, 0, 0, 0, 0};
+    CookedTexture decoded;
+    std::vector<unsigned char> pixels;
+    CHECK(decompress(blockTexture(formatBc2, 4, 4, 16), bc2, decoded, pixels));
+    CHECK((pixel(pixels, 4, 0, 0) == std::array<unsigned char, 4>{0, 0, 255, 0}));
+    CHECK((pixel(pixels, 4, 1, 0) == std::array<unsigned char, 4>{0, 0, 255, 255}));
+
+    // BC3: 8 interpolated alphas when alpha0 > alpha1, 3 bits per texel: 0, 1, 2, 0, ...
+    unsigned char bc3[16] = {255, 0, 0x88, 0, 0, 0, 0, 0, 0x1f, 0x00, 0x00, 0xf8, 0, 0, 0, 0};
+    CHECK(decompress(blockTexture(formatBc3, 4, 4, 16), bc3, decoded, pixels));
+    CHECK(pixel(pixels, 4, 0, 0)[3] == 255);
+    CHECK(pixel(pixels, 4, 1, 0)[3] == 0);
+    CHECK(pixel(pixels, 4, 2, 0)[3] == 218);
+
+    // 6 alphas, 0 and 255 otherwise, indices 7, 6, 2
+    bc3[0] = 0;
+    bc3[1] = 100;
+    bc3[2] = 0xb7;
+    CHECK(decompress(blockTexture(formatBc3, 4, 4, 16), bc3, decoded, pixels));
+    CHECK(pixel(pixels, 4, 0, 0)[3] == 255);
+    CHECK(pixel(pixels, 4, 1, 0)[3] == 0);
+    CHECK(pixel(pixels, 4, 2, 0)[3] == 20);
+}
+
+// Flipping the blocks must give the same texels as flipping the decoded image
+static void flip(const uint32_t internalFormat, const int width, const int height, std::mt19937 &random) {
+    const size_t size = imageSize(internalFormat, width, height);
+    std::vector<unsigned char> bytes(size);
+    for (auto &byte: bytes) {
+        byte = static_cast<unsigned char>(random());
+    }
+    const CookedTexture texture = blockTexture(internalFormat, width, height, size);
+
+    CookedTexture decoded;
+    std::vector<unsigned char> expected, flipped;
+    CHECK(decompress(texture, bytes, decoded, expected));
+    const char *failureReason = nullptr;
+    CHECK(flipVertically(decoded, expected, failureReason));
+    CHECK(flipVertically(texture, bytes, failureReason));
+    CHECK(decompress(texture, bytes, decoded, flipped));
+    CHECK(flipped == expected);
+}
+
+static void flips() {
+    std::mt19937 random(1);
+    for (const uint32_t format: {formatBc1, formatBc1Alpha, formatBc2, formatBc3Srgb}) {
+        for (int i = 0; i < 64; i++) {
+            flip(format, 8, 12, random);
+            flip(format, 5, 4, random);
+            // A single row of blocks only has its top rows used
+            flip(format, 4, 2, random);
+            flip(format, 1, 1, random);
+        }
+    }
+
+    // Uncompressed rows swap whole
+    unsigned char rows[] = {1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3};
+    CookedTexture texture = blockTexture(formatRgba8, 1, 3, sizeof(rows));
+    texture.format = pixelFormatRgba;
+    const char *failureReason = nullptr;
+    CHECK(flipVertically(texture, rows, failureReason));
+    CHECK(rows[0] == 3 && rows[4] == 2 && rows[8] == 1);
+
+    // Partial rows of blocks below the first one can't be flipped
+    std::vector<unsigned char> bytes(imageSize(formatBc1, 4, 6));
+    CHECK(not flipVertically(blockTexture(formatBc1, 4, 6, bytes.size()), bytes, failureReason));
+}
+
+int main() {
+    bc1();
+    alpha();
+    flips();
+    return testResult();
+}
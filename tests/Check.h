@@ -0,0 +1,32 @@
+#pragma once
+
+#ifndef OPENGL_TEST_CHECK_H
+#define OPENGL_TEST_CHECK_H
+
+#include <cstdio>
+
+/*
+ * Just enough of a test framework for the tests of the CPU side modules. Each test is its own
+ * executable registered with CTest, CHECK logs failures and keeps going, main returns testResult().
+ */
+
+inline int checkFailures = 0;
+
+#define CHECK(condition)                                                                      \
+    do {                                                                                      \
+        if (not(condition)) {                                                                 \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            checkFailures++;                                                                  \
+        }                                                                                     \
+    } while (false)
+
+inline int testResult() {
+    if (checkFailures != 0) {
+        std::fprintf(stderr, "%d checks failed\n", checkFailures);
+        return 1;
+    }
+    return 0;
+}
+
+
+#endif //OPENGL_TEST_CHECK_H
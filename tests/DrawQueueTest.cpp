@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "Check.h"
+#include "DrawQueue.h"
+
+// The radix sort must give the same order as a stable comparison sort
+static void matchesStableSort() {
+    std::mt19937 random(1);
+    DrawQueue queue;
+    for (const size_t count: {0, 1, 2, 17, 1000, 5000}) {
+        queue.clear();
+        for (size_t i = 0; i < count; i++) {
+            DrawPacket packet;
+            packet.pass = random() % 4 == 0 ? RenderPass::Transparent : RenderPass::Opaque;
+            // Few distinct values, so that equal keys are common
+            packet.program = 1 + random() % 3;
+            packet.texture = random() % 5;
+            packet.vertexArray = 1 + random() % 2;
+            queue.submit(packet, static_cast<float>(random() % 8) / 8.0f);
+        }
+        queue.sort();
+
+        std::vector<uint32_t> expected(count);
+        std::iota(expected.begin(), expected.end(), 0);
+        std::ranges::stable_sort(expected, {}, [&queue](const uint32_t index) { return queue.packets[index].key; });
+        CHECK(queue.order == expected);
+        CHECK(std::ranges::is_sorted(queue.keys));
+    }
+}
+
+static void keys() {
+    const uint64_t near = DrawQueue::makeKey(RenderPass::Opaque, 1, 1, 1, 0.1f);
+    const uint64_t far = DrawQueue::makeKey(RenderPass::Opaque, 1, 1, 1, 0.9f);
+    const uint64_t otherProgram = DrawQueue::makeKey(RenderPass::Opaque, 2, 1, 1, 0.0f);
+    const uint64_t transparentNear = DrawQueue::makeKey(RenderPass::Transparent, 1, 1, 1, 0.1f);
+    const uint64_t transparentFar = DrawQueue::makeKey(RenderPass::Transparent, 2, 1, 1, 0.9f);
+
+    // Opaque first, grouped by state then front to back
+    CHECK(near < far && far < otherProgram);
+    CHECK(otherProgram < transparentFar);
+    // Transparent back to front, whatever the state
+    CHECK(transparentFar < transparentNear);
+
+    // Depth outside [0, 1] is clamped rather than spilling into the state bits
+    CHECK(DrawQueue::makeKey(RenderPass::Opaque, 1, 1, 1, 2.0f) == DrawQueue::makeKey(RenderPass::Opaque, 1, 1, 1, 1.0f));
+    CHECK(DrawQueue::makeKey(RenderPass::Opaque, 1, 1, 1, -1.0f) == DrawQueue::makeKey(RenderPass::Opaque, 1, 1, 1, 0.0f));
+}
+
+int main() {
+    matchesStableSort();
+    keys();
+    return testResult();
+}
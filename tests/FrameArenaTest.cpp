@@ -0,0 +1,61 @@
+#include <cstdint>
+#include <cstring>
+
+#include "Check.h"
+#include "FrameArena.h"
+
+static bool aligned(const void *pointer, const size_t alignment) {
+    return reinterpret_cast<uintptr_t>(pointer) % alignment == 0;
+}
+
+static void alignment() {
+    FrameArena arena;
+    arena.init(1024);
+
+    auto *first = static_cast<std::byte *>(arena.allocate(0, 3, 1));
+    auto *second = static_cast<std::byte *>(arena.allocate(0, 16, 64));
+    CHECK(aligned(second, 64));
+    CHECK(second >= first + 3);
+    const auto doubles = arena.allocateArray<double>(0, 4);
+    CHECK(doubles.size() == 4 && aligned(doubles.data(), alignof(double)));
+    CHECK(reinterpret_cast<std::byte *>(doubles.data()) >= second + 16);
+    CHECK(arena.allocateArray<int>(0, 0).empty());
+
+    // Regions are independent
+    CHECK(arena.regions[1].used == 0);
+    arena.allocate(1, 8, 8);
+    CHECK(arena.regions[1].used == 8);
+}
+
+static void overflow() {
+    FrameArena arena;
+    arena.init(256);
+
+    // The region runs out, the rest comes from the heap and stays valid until reset
+    auto *inRegion = static_cast<unsigned char *>(arena.allocate(2, 200, 16));
+    auto *spilled = static_cast<unsigned char *>(arena.allocate(2, 300, 32));
+    CHECK(aligned(spilled, 32));
+    memset(inRegion, 1, 200);
+    memset(spilled, 2, 300);
+    CHECK(inRegion[199] == 1 && spilled[0] == 2);
+    CHECK(arena.regions[2].overflow.size() == 1);
+
+    arena.reset(2);
+    CHECK(arena.frames == 1 && arena.overflowFrames == 1);
+    CHECK(arena.lastFrameBytes >= 500 && arena.peakFrameBytes == arena.lastFrameBytes);
+    // Grown so that the same frame fits next time
+    CHECK(arena.regions[2].capacity >= arena.lastFrameBytes && arena.regions[2].overflow.empty());
+    CHECK(arena.regions[2].used == 0);
+
+    arena.allocate(2, 200, 16);
+    arena.allocate(2, 300, 32);
+    CHECK(arena.regions[2].overflow.empty());
+    arena.reset(2);
+    CHECK(arena.frames == 2 && arena.overflowFrames == 1);
+}
+
+int main() {
+    alignment();
+    overflow();
+    return testResult();
+}
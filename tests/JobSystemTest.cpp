@@ -0,0 +1,94 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "Check.h"
+#include "JobSystem.h"
+
+// Counters on the stack, freed the moment wait() returns, while workers may still be finishing with them
+static void stressStackCounters(JobSystem &jobs) {
+    for (int iteration = 0; iteration < 20000; iteration++) {
+        std::atomic<size_t> covered = 0;
+        jobs.parallelFor(64, 1 + iteration % 8, [&covered](const size_t begin, const size_t end) {
+            covered += end - begin;
+        });
+        CHECK(covered == 64);
+    }
+}
+
+static void nestedParallelFor(JobSystem &jobs) {
+    std::atomic<size_t> covered = 0;
+    jobs.parallelFor(16, 1, [&jobs, &covered](size_t, size_t) {
+        jobs.parallelFor(16, 1, [&covered](const size_t begin, const size_t end) {
+            covered += end - begin;
+        });
+    });
+    CHECK(covered == 16 * 16);
+}
+
+static void dependencies(JobSystem &jobs) {
+    for (int iteration = 0; iteration < 1000; iteration++) {
+        std::atomic<int> stage = 0;
+        std::atomic<bool> ordered = true;
+        JobCounter first;
+        JobCounter second;
+        for (int i = 0; i < 4; i++) {
+            jobs.run([&stage] { ++stage; }, &first);
+        }
+        jobs.run([&stage, &ordered] {
+            if (stage != 4) {
+                ordered = false;
+            }
+        }, &second, &first);
+        jobs.wait(second);
+        CHECK(ordered);
+    }
+}
+
+// A waiter with nothing to steal sleeps, it must still wake up when the last job is done
+static void longJobs(JobSystem &jobs) {
+    for (int iteration = 0; iteration < 20; iteration++) {
+        JobCounter counter;
+        std::atomic<int> finished = 0;
+        for (int i = 0; i < 2; i++) {
+            jobs.run([&finished] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                ++finished;
+            }, &counter);
+        }
+        jobs.wait(counter);
+        CHECK(finished == 2);
+    }
+}
+
+// Without queues, before init() and after shutdown(), jobs run inline
+static void withoutWorkers(JobSystem &jobs) {
+    std::atomic<size_t> covered = 0;
+    jobs.parallelFor(64, 8, [&covered](const size_t begin, const size_t end) {
+        covered += end - begin;
+    });
+    CHECK(covered == 64);
+
+    JobCounter first, second;
+    bool ran = false;
+    jobs.run([] {}, &first);
+    jobs.run([&ran] { ran = true; }, &second, &first);
+    jobs.wait(second);
+    CHECK(ran);
+}
+
+int main() {
+    JobSystem jobs;
+    withoutWorkers(jobs);
+    // A fixed number of workers, so that jobs interleave even on a single core
+    jobs.init(4);
+
+    stressStackCounters(jobs);
+    nestedParallelFor(jobs);
+    dependencies(jobs);
+    longJobs(jobs);
+
+    jobs.shutdown();
+    withoutWorkers(jobs);
+    return testResult();
+}
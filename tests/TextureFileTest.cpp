@@ -0,0 +1,225 @@
+#include <cstring>
+#include <vector>
+
+#include "Check.h"
+#include "TextureFile.h"
+
+static void append(std::vector<unsigned char> &bytes, const void *data, const size_t size) {
+    const auto *begin = static_cast<const unsigned char *>(data);
+    bytes.insert(bytes.end(), begin, begin + size);
+}
+
+static void appendLevel(std::vector<unsigned char> &bytes, const uint32_t size, const bool sizePrefixed) {
+    if (sizePrefixed) {
+        append(bytes, &size, sizeof(size));
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        bytes.push_back(static_cast<unsigned char>(i));
+    }
+    // KTX pads levels to 4 bytes
+    while (sizePrefixed && bytes.size() % 4 != 0) {
+        bytes.push_back(0);
+    }
+}
+
+static KtxHeader ktxHeader(const uint32_t internalFormat, const uint32_t width, const uint32_t height, const uint32_t levels) {
+    KtxHeader header{};
+    memcpy(header.identifier, ktxIdentifier, sizeof(ktxIdentifier));
+    header.endianness = ktxEndianness;
+    const bool compressed = blockSize(internalFormat) != 0;
+    header.glType = compressed ? 0 : pixelTypeUnsignedByte;
+    header.glTypeSize = 1;
+    header.glFormat = compressed ? 0 : pixelFormatRgba;
+    header.glInternalFormat = internalFormat;
+    header.glBaseInternalFormat = pixelFormatRgba;
+    header.pixelWidth = width;
+    header.pixelHeight = height;
+    header.numberOfFaces = 1;
+    header.numberOfMipmapLevels = levels;
+    return header;
+}
+
+static void ktx() {
+    // 6x3 RGBA8 with its full chain: 6x3, 3x1, 1x1
+    std::vector<unsigned char> bytes;
+    KtxHeader header = ktxHeader(formatRgba8, 6, 3, 3);
+    header.bytesOfKeyValueData = 8;
+    append(bytes, &header, sizeof(header));
+    bytes.resize(bytes.size() + header.bytesOfKeyValueData);
+    appendLevel(bytes, 6 * 3 * 4, true);
+    appendLevel(bytes, 3 * 1 * 4, true);
+    appendLevel(bytes, 1 * 1 * 4, true);
+
+    CookedTexture texture;
+    const char *failureReason = nullptr;
+    CHECK(parseTextureFile(bytes, texture, failureReason));
+    CHECK(texture.internalFormat == formatRgba8 && not texture.compressed() && not texture.topDown);
+    CHECK(texture.width == 6 && texture.height == 3);
+    CHECK(texture.levels.size() == 3);
+    if (texture.levels.size() == 3) {
+        CHECK(texture.levels[0].offset == 64 + 8 + 4 && texture.levels[0].size == 72);
+        CHECK(texture.levels[1].width == 3 && texture.levels[1].height == 1 && texture.levels[1].size == 12);
+        CHECK(texture.levels[1].offset == texture.levels[0].offset + 72 + 4);
+        CHECK(texture.levels[2].width == 1 && texture.levels[2].height == 1);
+    }
+
+    // Every truncation fails instead of reading past the end
+    for (size_t size = 0; size < bytes.size(); size++) {
+        CHECK(not parseKtx(std::span(bytes).first(size), texture, failureReason));
+    }
+
+    // BC1 blocks, with a level whose stored size doesn't match its dimensions
+    bytes.clear();
+    header = ktxHeader(formatBc1, 8, 8, 2);
+    append(bytes, &header, sizeof(header));
+    appendLevel(bytes, 32, true);
+    appendLevel(bytes, 16, true);
+    CHECK(not parseKtx(bytes, texture, failureReason));
+
+    // More levels than a full chain
+    bytes.clear();
+    header = ktxHeader(formatBc1, 4, 4, 4);
+    append(bytes, &header, sizeof(header));
+    for (int level = 0; level < 4; level++) {
+        appendLevel(bytes, 8, true);
+    }
+    CHECK(not parseKtx(bytes, texture, failureReason));
+
+    // Cube maps and unknown formats
+    header = ktxHeader(formatRgba8, 4, 4, 1);
+    header.numberOfFaces = 6;
+    bytes.assign(sizeof(header), 0);
+    memcpy(bytes.data(), &header, sizeof(header));
+    appendLevel(bytes, 64, true);
+    CHECK(not parseKtx(bytes, texture, failureReason));
+    header.numberOfFaces = 1;
+    header.glInternalFormat = 0x1234;
+    memcpy(bytes.data(), &header, sizeof(header));
+    CHECK(not parseKtx(bytes, texture, failureReason));
+}
+
+struct DdsFile {
+    uint32_t magic = 0x20534444;
+    uint32_t size = 124;
+    uint32_t flags{};
+    uint32_t height{};
+    uint32_t width{};
+    uint32_t pitchOrLinearSize{};
+    uint32_t depth{};
+    uint32_t mipMapCount{};
+    uint32_t reserved1[11]{};
+    uint32_t pixelFormatSize = 32;
+    uint32_t pixelFormatFlags{};
+    uint32_t fourCC{};
+    uint32_t rgbBitCount{};
+    uint32_t masks[4]{};
+    uint32_t caps[4]{};
+    uint32_t reserved2{};
+};
+
+static_assert(sizeof(DdsFile) == 128);
+
+static uint32_t fourCC(const char (&code)[5]) {
+    uint32_t value = 0;
+    memcpy(&value, code, sizeof(value));
+    return value;
+}
+
+static void dds() {
+    // DXT1 8x8 with its full chain: 4, 1, 1 and 1 blocks
+    DdsFile header;
+    header.flags = 0x20000;
+    header.width = 8;
+    header.height = 8;
+    header.mipMapCount = 4;
+    header.pixelFormatFlags = 0x4;
+    header.fourCC = fourCC("DXT1");
+    std::vector<unsigned char> bytes;
+    append(bytes, &header, sizeof(header));
+    appendLevel(bytes, 32, false);
+    for (int level = 1; level < 4; level++) {
+        appendLevel(bytes, 8, false);
+    }
+
+    CookedTexture texture;
+    const char *failureReason = nullptr;
+    CHECK(parseTextureFile(bytes, texture, failureReason));
+    CHECK(texture.internalFormat == formatBc1Alpha && texture.compressed() && texture.topDown);
+    CHECK(texture.levels.size() == 4);
+    if (texture.levels.size() == 4) {
+        CHECK(texture.levels[0].offset == 128 && texture.levels[0].size == 32);
+        CHECK(texture.levels[3].offset == 128 + 32 + 16 && texture.levels[3].width == 1);
+    }
+    CHECK(not parseDds(std::span(bytes).first(bytes.size() - 1), texture, failureReason));
+
+    // Without DDSD_MIPMAPCOUNT the count is ignored
+    header.flags = 0;
+    memcpy(bytes.data(), &header, sizeof(header));
+    CHECK(parseDds(bytes, texture, failureReason) && texture.levels.size() == 1);
+
+    // BGRA through the legacy pixel format
+    header = DdsFile{};
+    header.width = 2;
+    header.height = 2;
+    header.pixelFormatFlags = 0x40;
+    header.rgbBitCount = 32;
+    header.masks[0] = 0x00ff0000;
+    header.masks[1] = 0x0000ff00;
+    header.masks[2] = 0x000000ff;
+    bytes.clear();
+    append(bytes, &header, sizeof(header));
+    appendLevel(bytes, 16, false);
+    CHECK(parseDds(bytes, texture, failureReason));
+    CHECK(texture.internalFormat == formatRgba8 && texture.format == pixelFormatBgra && texture.type == pixelTypeUnsignedByte);
+
+    // BC7 through a DX10 header
+    header = DdsFile{};
+    header.width = 4;
+    header.height = 4;
+    header.pixelFormatFlags = 0x4;
+    header.fourCC = fourCC("DX10");
+    const uint32_t dx10[5] = {98, 3, 0, 1, 0};
+    bytes.clear();
+    append(bytes, &header, sizeof(header));
+    append(bytes, dx10, sizeof(dx10));
+    appendLevel(bytes, 16, false);
+    CHECK(parseDds(bytes, texture, failureReason));
+    CHECK(texture.internalFormat == formatBc7 && texture.levels.size() == 1 && texture.levels[0].offset == 148);
+
+    // Volume textures
+    header = DdsFile{};
+    header.width = 4;
+    header.height = 4;
+    header.pixelFormatFlags = 0x4;
+    header.fourCC = fourCC("DXT5");
+    header.caps[1] = 0x200000;
+    bytes.clear();
+    append(bytes, &header, sizeof(header));
+    appendLevel(bytes, 16, false);
+    CHECK(not parseDds(bytes, texture, failureReason));
+}
+
+static void formats() {
+    CHECK(blockSize(formatBc1) == 8 && blockSize(formatBc3) == 16 && blockSize(formatRgba8) == 0);
+    CHECK(imageSize(formatRgba8, 3, 5) == 60);
+    // Partial blocks count whole
+    CHECK(imageSize(formatBc1, 5, 1) == 16);
+    CHECK(imageSize(formatBc3, 1, 1) == 16);
+
+    TextureCapabilities capabilities;
+    capabilities.s3tc = true;
+    CHECK(capabilities.supports(formatBc1) && not capabilities.supports(formatBc1Srgb));
+    CHECK(capabilities.supports(formatBc4) && not capabilities.supports(formatBc7));
+
+    CookedTexture texture;
+    const char *failureReason = nullptr;
+    const unsigned char garbage[16]{};
+    CHECK(not parseTextureFile(garbage, texture, failureReason) && failureReason);
+}
+
+int main() {
+    ktx();
+    dds();
+    formats();
+    return testResult();
+}
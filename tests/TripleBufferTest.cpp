@@ -0,0 +1,78 @@
+#include <atomic>
+#include <thread>
+
+#include "Check.h"
+#include "TripleBuffer.h"
+
+static void handOver() {
+    TripleBuffer<int> buffer;
+    CHECK(not buffer.consume());
+
+    buffer.writeBuffer() = 1;
+    buffer.publish();
+    CHECK(buffer.consume() && buffer.readBuffer() == 1);
+    // Nothing new, the consumer keeps what it has
+    CHECK(not buffer.consume() && buffer.readBuffer() == 1);
+
+    // A producer running ahead overwrites the unconsumed buffer
+    buffer.writeBuffer() = 2;
+    buffer.publish();
+    buffer.writeBuffer() = 3;
+    buffer.publish();
+    CHECK(buffer.consume() && buffer.readBuffer() == 3);
+
+    // The three slots stay distinct
+    const uint8_t slot = buffer.writeSlot();
+    CHECK(&buffer.writeBuffer() == &buffer.buffers[slot]);
+    CHECK(&buffer.writeBuffer() != &buffer.readBuffer());
+}
+
+struct Frame {
+    int sequence{};
+    int copy{};
+};
+
+// The consumer only ever sees whole frames, in order
+static void threads() {
+    TripleBuffer<Frame> buffer;
+    constexpr int frames = 200000;
+    std::atomic<bool> done = false;
+
+    std::thread producer([&buffer, &done] {
+        for (int sequence = 1; sequence <= frames; sequence++) {
+            Frame &frame = buffer.writeBuffer();
+            frame.sequence = sequence;
+            frame.copy = sequence;
+            buffer.publish();
+        }
+        done = true;
+    });
+
+    int last = 0;
+    bool torn = false, backwards = false;
+    while (true) {
+        // Read before consuming, so that the last frame is picked up before leaving
+        const bool finished = done;
+        if (not buffer.consume()) {
+            if (finished) {
+                break;
+            }
+            continue;
+        }
+        const Frame &frame = buffer.readBuffer();
+        torn |= frame.sequence != frame.copy;
+        backwards |= frame.sequence <= last;
+        last = frame.sequence;
+    }
+    producer.join();
+
+    CHECK(not torn);
+    CHECK(not backwards);
+    CHECK(buffer.readBuffer().sequence == frames);
+}
+
+int main() {
+    handOver();
+    threads();
+    return testResult();
+}
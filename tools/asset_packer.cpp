@@ -0,0 +1,115 @@
+// Builds the asset pack read by AssetPack (see src/AssetPack.h for the layout):
+//   asset_packer <output> <root> <asset>...
+// Assets are paths relative to root, and are looked up by that same path at runtime.
+// An asset written as path=file packs file (built somewhere else, like cooked textures) under path.
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "AssetPack.h"
+#include "Hash.h"
+
+using namespace std;
+
+struct PackedAsset {
+    string path;
+    vector<unsigned char> contents;
+    AssetPackEntry entry{};
+};
+
+static uint64_t alignUp(const uint64_t value, const uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static bool readFile(const string &path, vector<unsigned char> &contents) {
+    ifstream file(path, ios::binary);
+    if (not file) {
+        return false;
+    }
+    contents.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    return not file.bad();
+}
+
+int main(const int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <output> <root> <asset>...\n", argv[0]);
+        return 1;
+    }
+    const string output = argv[1];
+    const string root = argv[2];
+
+    vector<PackedAsset> assets;
+    for (int i = 3; i < argc; i++) {
+        const string argument = argv[i];
+        const size_t separator = argument.find('=');
+
+        PackedAsset asset;
+        asset.path = argument.substr(0, separator);
+        const string file = separator == string::npos ? root + "/" + asset.path : argument.substr(separator + 1);
+        if (not readFile(file, asset.contents)) {
+            fprintf(stderr, "asset_packer: could not read %s\n", file.c_str());
+            return 1;
+        }
+        asset.entry.pathHash = hashString(asset.path);
+        asset.entry.contentHash = hashBytes(asset.contents.data(), asset.contents.size());
+        asset.entry.size = asset.contents.size();
+        assets.push_back(std::move(asset));
+    }
+
+    // Lookups binary search the table by path hash, ties are resolved by comparing the paths
+    ranges::sort(assets, [](const PackedAsset &a, const PackedAsset &b) {
+        return tie(a.entry.pathHash, a.path) < tie(b.entry.pathHash, b.path);
+    });
+
+    AssetPackHeader header{};
+    header.magic = assetPackMagic;
+    header.version = assetPackVersion;
+    header.entryCount = assets.size();
+    header.pathsOffset = sizeof(AssetPackHeader) + assets.size() * sizeof(AssetPackEntry);
+
+    string paths;
+    for (auto &asset: assets) {
+        asset.entry.pathOffset = static_cast<uint32_t>(paths.size());
+        asset.entry.pathLength = static_cast<uint32_t>(asset.path.size());
+        paths += asset.path;
+    }
+
+    uint64_t offset = header.pathsOffset + paths.size();
+    for (auto &asset: assets) {
+        offset = alignUp(offset, assetPackAlignment);
+        asset.entry.offset = offset;
+        offset += asset.entry.size;
+    }
+    header.fileSize = offset;
+
+    ofstream file(output, ios::binary | ios::trunc);
+    if (not file) {
+        fprintf(stderr, "asset_packer: could not write %s\n", output.c_str());
+        return 1;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const auto &asset: assets) {
+        file.write(reinterpret_cast<const char *>(&asset.entry), sizeof(asset.entry));
+    }
+    file.write(paths.data(), static_cast<streamsize>(paths.size()));
+
+    for (const auto &asset: assets) {
+        const auto padding = static_cast<size_t>(asset.entry.offset - static_cast<uint64_t>(file.tellp()));
+        const string zeros(padding, '\0');
+        file.write(zeros.data(), static_cast<streamsize>(zeros.size()));
+        file.write(reinterpret_cast<const char *>(asset.contents.data()), static_cast<streamsize>(asset.contents.size()));
+    }
+
+    if (not file.flush()) {
+        fprintf(stderr, "asset_packer: could not write %s\n", output.c_str());
+        return 1;
+    }
+    printf("asset_packer: packed %zu assets into %s (%llu bytes)\n", assets.size(), output.c_str(),
+           (unsigned long long) header.fileSize);
+    return 0;
+}
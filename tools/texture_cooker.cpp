@@ -0,0 +1,283 @@
+// Cooks a source image into a KTX file the runtime uploads as is (see src/TextureFile.h):
+//   texture_cooker [--format auto|rgba8|bc1|bc3] <input> <output.ktx>
+// The whole mip chain is generated here with MipGenerator, and BC1/BC3 use 4-8x less memory than the
+// decoded image.
+// auto picks BC1 for opaque images and BC3 for images with alpha.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BlockFormat.h"
+#include "MipGenerator.h"
+#include "TextureFile.h"
+
+#include "../vendored/stb_image.h"
+
+using namespace std;
+
+struct Image {
+    int width{};
+    int height{};
+    // RGBA, bottom row first like the runtime loads images
+    vector<unsigned char> pixels;
+};
+
+using Block = array<array<unsigned char, 4>, 16>;
+
+// Edge blocks of sizes that aren't a multiple of 4 repeat the last row and column
+static Block readBlock(const Image &image, const int blockX, const int blockY) {
+    Block block{};
+    for (int i = 0; i < 16; i++) {
+        const int x = min(blockX * 4 + i % 4, image.width - 1);
+        const int y = min(blockY * 4 + i / 4, image.height - 1);
+        memcpy(block[i].data(), &image.pixels[(static_cast<size_t>(y) * image.width + x) * 4], 4);
+    }
+    return block;
+}
+
+static uint16_t to565(const float r, const float g, const float b) {
+    const auto quantize = [](const float value, const int maximum) {
+        return static_cast<uint16_t>(clamp(lround(value / 255.0f * maximum), 0l, static_cast<long>(maximum)));
+    };
+    return static_cast<uint16_t>(quantize(r, 31) << 11 | quantize(g, 63) << 5 | quantize(b, 31));
+}
+
+/**
+ * Endpoints are the extremes of the block's colors along their principal axis, pulled in by 1/16 of
+ * the range since the extremes themselves are rarely hit exactly.
+ */
+static void encodeColorBlock(const Block &block, unsigned char *out) {
+    array<float, 3> mean{};
+    for (const auto &pixel: block) {
+        for (int c = 0; c < 3; c++) {
+            mean[c] += pixel[c] / 16.0f;
+        }
+    }
+
+    array<float, 6> covariance{};
+    for (const auto &pixel: block) {
+        const float r = pixel[0] - mean[0], g = pixel[1] - mean[1], b = pixel[2] - mean[2];
+        covariance[0] += r * r;
+        covariance[1] += r * g;
+        covariance[2] += r * b;
+        covariance[3] += g * g;
+        covariance[4] += g * b;
+        covariance[5] += b * b;
+    }
+
+    // A few power iterations converge well enough on a 3x3 matrix
+    array<float, 3> axis{1, 1, 1};
+    for (int iteration = 0; iteration < 8; iteration++) {
+        const array<float, 3> next{
+            covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+            covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+            covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2],
+        };
+        const float length = sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+        if (length < 1e-6f) {
+            break;
+        }
+        axis = {next[0] / length, next[1] / length, next[2] / length};
+    }
+
+    float lowest = 0, highest = 0;
+    for (const auto &pixel: block) {
+        const float projection = (pixel[0] - mean[0]) * axis[0] + (pixel[1] - mean[1]) * axis[1] + (pixel[2] - mean[2]) * axis[2];
+        lowest = min(lowest, projection);
+        highest = max(highest, projection);
+    }
+    const float inset = (highest - lowest) / 16.0f;
+    lowest += inset;
+    highest -= inset;
+
+    uint16_t color0 = to565(mean[0] + axis[0] * highest, mean[1] + axis[1] * highest, mean[2] + axis[2] * highest);
+    uint16_t color1 = to565(mean[0] + axis[0] * lowest, mean[1] + axis[1] * lowest, mean[2] + axis[2] * lowest);
+    // color0 > color1 selects the 4 color mode, with equal endpoints every index picks color0 anyway
+    if (color0 < color1) {
+        swap(color0, color1);
+    }
+
+    const auto end0 = from565(color0), end1 = from565(color1);
+    array<array<int, 3>, 4> palette{end0, end1};
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * end0[c] + end1[c]) / 3;
+        palette[3][c] = (end0[c] + 2 * end1[c]) / 3;
+    }
+
+    uint32_t indices = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0, bestDistance = INT32_MAX;
+        for (int candidate = 0; candidate < 4; candidate++) {
+            int distance = 0;
+            for (int c = 0; c < 3; c++) {
+                const int difference = block[i][c] - palette[candidate][c];
+                distance += difference * difference;
+            }
+            if (distance < bestDistance) {
+                best = candidate;
+                bestDistance = distance;
+            }
+        }
+        indices |= static_cast<uint32_t>(best) << (2 * i);
+    }
+
+    writeLittleEndian(out, color0, 2);
+    writeLittleEndian(out + 2, color1, 2);
+    writeLittleEndian(out + 4, indices, 4);
+}
+
+// BC3 alpha: the block's alpha range split in 8 steps, 3 bit indices
+static void encodeAlphaBlock(const Block &block, unsigned char *out) {
+    int alpha0 = 0, alpha1 = 255;
+    for (const auto &pixel: block) {
+        alpha0 = max<int>(alpha0, pixel[3]);
+        alpha1 = min<int>(alpha1, pixel[3]);
+    }
+
+    array<int, 8> palette{alpha0, alpha1};
+    for (int i = 1; i < 7; i++) {
+        palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+    }
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0;
+        for (int candidate = 1; candidate < 8; candidate++) {
+            if (abs(block[i][3] - palette[candidate]) < abs(block[i][3] - palette[best])) {
+                best = candidate;
+            }
+        }
+        indices |= static_cast<uint64_t>(best) << (3 * i);
+    }
+
+    out[0] = static_cast<unsigned char>(alpha0);
+    out[1] = static_cast<unsigned char>(alpha1);
+    writeLittleEndian(out + 2, indices, 6);
+}
+
+static vector<unsigned char> encode(const Image &image, const uint32_t internalFormat) {
+    if (internalFormat == formatRgba8) {
+        return image.pixels;
+    }
+
+    const int blocksWide = (image.width + 3) / 4;
+    const int blocksHigh = (image.height + 3) / 4;
+    const size_t bytes = blockSize(internalFormat);
+    vector<unsigned char> result(imageSize(internalFormat, image.width, image.height));
+
+    for (int blockY = 0; blockY < blocksHigh; blockY++) {
+        for (int blockX = 0; blockX < blocksWide; blockX++) {
+            const Block block = readBlock(image, blockX, blockY);
+            unsigned char *out = &result[(static_cast<size_t>(blockY) * blocksWide + blockX) * bytes];
+            if (internalFormat == formatBc3) {
+                encodeAlphaBlock(block, out);
+                out += 8;
+            }
+            encodeColorBlock(block, out);
+        }
+    }
+    return result;
+}
+
+static bool writeKtx(const string &path, const uint32_t internalFormat, const vector<Image> &levels, const vector<vector<unsigned char>> &data) {
+    KtxHeader header{};
+    memcpy(header.identifier, ktxIdentifier, sizeof(ktxIdentifier));
+    header.endianness = ktxEndianness;
+    header.glInternalFormat = internalFormat;
+    if (internalFormat == formatRgba8) {
+        header.glType = pixelTypeUnsignedByte;
+        header.glTypeSize = 1;
+        header.glFormat = pixelFormatRgba;
+    }
+    header.glBaseInternalFormat = internalFormat == formatBc1 ? pixelFormatRgb : pixelFormatRgba;
+    header.pixelWidth = static_cast<uint32_t>(levels[0].width);
+    header.pixelHeight = static_cast<uint32_t>(levels[0].height);
+    header.numberOfFaces = 1;
+    header.numberOfMipmapLevels = static_cast<uint32_t>(levels.size());
+
+    ofstream file(path, ios::binary | ios::trunc);
+    if (not file) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const auto &level: data) {
+        const auto size = static_cast<uint32_t>(level.size());
+        file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        file.write(reinterpret_cast<const char *>(level.data()), size);
+        constexpr char padding[3]{};
+        file.write(padding, (4 - size % 4) % 4);
+    }
+    return static_cast<bool>(file.flush());
+}
+
+int main(const int argc, char *argv[]) {
+    string_view format = "auto";
+    int argument = 1;
+    if (argc > 2 && string_view(argv[1]) == "--format") {
+        format = argv[2];
+        argument = 3;
+    }
+    if (argc - argument != 2 || (format != "auto" && format != "rgba8" && format != "bc1" && format != "bc3")) {
+        fprintf(stderr, "Usage: %s [--format auto|rgba8|bc1|bc3] <input> <output.ktx>\n", argv[0]);
+        return 1;
+    }
+    const char *input = argv[argument];
+    const string output = argv[argument + 1];
+
+    // Same orientation as TextureLoader, so that cooked and decoded textures look the same
+    stbi_set_flip_vertically_on_load(true);
+    Image image;
+    int channels = 0;
+    unsigned char *pixels = stbi_load(input, &image.width, &image.height, &channels, 4);
+    if (not pixels) {
+        fprintf(stderr, "texture_cooker: could not load %s (%s)\n", input, stbi_failure_reason());
+        return 1;
+    }
+    image.pixels.assign(pixels, pixels + static_cast<size_t>(image.width) * image.height * 4);
+    stbi_image_free(pixels);
+
+    uint32_t internalFormat = format == "rgba8" ? formatRgba8 : format == "bc1" ? formatBc1 : formatBc3;
+    if (format == "auto") {
+        bool opaque = true;
+        for (size_t i = 3; i < image.pixels.size() && opaque; i += 4) {
+            opaque = image.pixels[i] == 255;
+        }
+        internalFormat = opaque ? formatBc1 : formatBc3;
+    }
+
+    // Same filter as the runtime's --cpu-mipmaps, color is averaged in linear light rather than on sRGB bytes
+    const MipGenerator mipGenerator;
+    vector<unsigned char> chain;
+    vector<TextureLevel> chainLevels;
+    mipGenerator.generate(image.pixels.data(), image.width, image.height, chain, chainLevels);
+
+    vector<Image> levels;
+    for (const auto &level: chainLevels) {
+        const auto first = chain.begin() + static_cast<ptrdiff_t>(level.offset);
+        levels.push_back({level.width, level.height, {first, first + static_cast<ptrdiff_t>(level.size)}});
+    }
+
+    vector<vector<unsigned char>> data;
+    size_t cookedSize = 0, rawSize = 0;
+    for (const auto &level: levels) {
+        data.push_back(encode(level, internalFormat));
+        cookedSize += data.back().size();
+        rawSize += level.pixels.size();
+    }
+
+    if (not writeKtx(output, internalFormat, levels, data)) {
+        fprintf(stderr, "texture_cooker: could not write %s\n", output.c_str());
+        return 1;
+    }
+    const char *formatName = internalFormat == formatRgba8 ? "RGBA8" : internalFormat == formatBc1 ? "BC1" : "BC3";
+    printf("texture_cooker: %s -> %s (%ix%i %s, %zu levels, %zu KiB instead of %zu KiB as RGBA8)\n", input, output.c_str(),
+           levels[0].width, levels[0].height, formatName, levels.size(), cookedSize / 1024, rawSize / 1024);
+    return 0;
+}